@@ -0,0 +1,381 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: AsyncTask.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef ASYNC_TASK_H_
+#define ASYNC_TASK_H_
+
+/**=============================================================================
+ * Definitions:
+ * ===========================================================================*/
+
+/**
+ * @brief Defined when the compiler supports C++20 coroutines, which the
+ *        asynchronous API of the list is built on. Otherwise, the list has its
+ *        blocking API only.
+ */
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define LIST_HAS_COROUTINES
+#endif
+
+#ifdef LIST_HAS_COROUTINES
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <utility>
+
+using std::coroutine_handle;
+using std::suspend_always;
+using std::noop_coroutine;
+using std::exception_ptr;
+using std::function;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief Resumes a coroutine whose lock was acquired on its behalf, e.g. by
+ *        posting it to a thread pool. If empty, the coroutine is posted to the
+ *        AsyncTrampoline of the thread that waits for it in AsyncTask::Get.
+ */
+typedef function<void(coroutine_handle<>)> AsyncScheduler;
+
+/**
+ * @brief Resumes coroutines on the thread that waits for them in
+ *        AsyncTask::Get.
+ * 
+ * Behavior:
+ *  - A coroutine whose lock was acquired on its behalf, and which has no
+ *    scheduler, is posted to the trampoline of the thread that runs it, rather
+ *    than resumed by the thread that released the lock. That thread may still
+ *    hold other locks, which the code after the co_await could wait for, and
+ *    would nest the resumed coroutines on its stack.
+ *  - The posted coroutines are resumed one at a time, until Complete is called.
+ *  - Trampolines nest: a Get called from a coroutine installs its own, and the
+ *    enclosing one is restored when it returns.
+ */
+class AsyncTrampoline {
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+private:
+
+    /**
+     * @brief Protects posted and isCompleted.
+     */
+    std::mutex trampolineMutex;
+
+    /**
+     * @brief Signaled when a coroutine is posted, or Complete is called.
+     */
+    std::condition_variable trampolineCondition;
+
+    /**
+     * @brief The coroutines to resume, in order.
+     */
+    std::deque<coroutine_handle<>> posted;
+
+    /**
+     * @brief Whether Complete was called.
+     */
+    bool isCompleted;
+
+    /**
+     * @brief The trampoline that was current when this one was installed.
+     */
+    AsyncTrampoline* const previous;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The current trampoline of the calling thread, if any.
+     * 
+     * @retval AsyncTrampoline*& The current trampoline.
+     */
+    static AsyncTrampoline*& CurrentOfThread() noexcept {
+        static thread_local AsyncTrampoline* current(nullptr);
+        return current;
+    }
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief Construct a new AsyncTrampoline object, and make it the current
+     *        trampoline of the calling thread.
+     */
+    AsyncTrampoline() noexcept : isCompleted(false),
+                                 previous(CurrentOfThread()) {
+        CurrentOfThread() = this;
+    }
+
+    AsyncTrampoline(const AsyncTrampoline&) = delete;
+    AsyncTrampoline& operator=(const AsyncTrampoline&) = delete;
+
+    /**
+     * @brief Restores the previous trampoline of the calling thread.
+     */
+    ~AsyncTrampoline() noexcept {
+        CurrentOfThread() = previous;
+    }
+
+    /**
+     * @brief The current trampoline of the calling thread.
+     * 
+     * @retval AsyncTrampoline* The trampoline, or nullptr if the thread does
+     *                          not run a coroutine by Get.
+     */
+    static AsyncTrampoline* Current() noexcept {
+        return CurrentOfThread();
+    }
+
+    /**
+     * @brief Posts a coroutine, to be resumed by Run. May be called by any
+     *        thread.
+     * 
+     * @param handle The coroutine.
+     */
+    void Post(const coroutine_handle<> handle) {
+        std::scoped_lock<std::mutex> lock(trampolineMutex);
+        posted.push_back(handle);
+        trampolineCondition.notify_one();
+    }
+
+    /**
+     * @brief Makes Run return once no coroutine is posted. May be called by any
+     *        thread.
+     */
+    void Complete() {
+        std::scoped_lock<std::mutex> lock(trampolineMutex);
+        isCompleted = true;
+        trampolineCondition.notify_one();
+    }
+
+    /**
+     * @brief Resumes the posted coroutines, one at a time and without holding
+     *        the mutex, until Complete is called.
+     */
+    void Run() {
+        std::unique_lock<std::mutex> lock(trampolineMutex);
+        while(true) {
+            trampolineCondition.wait(lock, [this]() {
+                return !posted.empty() || isCompleted;
+            });
+            if(posted.empty()) return;
+
+            const coroutine_handle<> handle(posted.front());
+            posted.pop_front();
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+        }
+    }
+};
+
+/**
+ * @brief A lazy coroutine that returns a value of type T.
+ * 
+ * Behavior:
+ *  - The coroutine starts when it is awaited, and resumes its awaiter when it
+ *    returns (by a symmetric transfer, so long chains do not grow the stack).
+ *  - An exception thrown by the coroutine is rethrown to its awaiter.
+ *  - Get runs the coroutine from a non-coroutine context, blocking the calling
+ *    thread until it returns. Meanwhile, the thread is the AsyncTrampoline of
+ *    the coroutine.
+ */
+template<typename T>
+class AsyncTask {
+
+/**-----------------------------------------------------------------------------
+ * Public Definitions:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The promise of the coroutine, as required by the language.
+     */
+    struct promise_type {
+
+        /**
+         * @brief The returned value.
+         */
+        T value;
+
+        /**
+         * @brief The thrown exception, if any.
+         */
+        exception_ptr exception;
+
+        /**
+         * @brief The awaiter to resume when the coroutine returns, if any.
+         */
+        coroutine_handle<> continuation;
+
+        /**
+         * @brief Called when the coroutine returns and there is no awaiter.
+         */
+        function<void()> onCompleted;
+
+        /**
+         * @brief Resumes the awaiter (or calls onCompleted) at the end of the
+         *        coroutine.
+         */
+        struct FinalAwaiter {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            coroutine_handle<> await_suspend(
+                        coroutine_handle<promise_type> handle) const noexcept {
+                promise_type& promise(handle.promise());
+                if(promise.continuation) return promise.continuation;
+
+                // The frame may be destroyed once it is called, so it is moved
+                // out of the frame first.
+                const function<void()> onCompleted(
+                                            std::move(promise.onCompleted));
+                if(onCompleted) onCompleted();
+                return noop_coroutine();
+            }
+
+            void await_resume() const noexcept {
+            }
+        };
+
+        AsyncTask get_return_object() noexcept {
+            return AsyncTask(
+                    coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        suspend_always initial_suspend() const noexcept {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() const noexcept {
+            return {};
+        }
+
+        void return_value(T in_value) {
+            value = std::move(in_value);
+        }
+
+        void unhandled_exception() noexcept {
+            exception = std::current_exception();
+        }
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+private:
+
+    /**
+     * @brief The coroutine.
+     */
+    coroutine_handle<promise_type> handle;
+
+    friend struct promise_type;
+
+    /**
+     * @brief Construct a new AsyncTask object, owning the coroutine.
+     */
+    explicit AsyncTask(const coroutine_handle<promise_type> in_handle) noexcept
+                                                        : handle(in_handle) {
+    }
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    AsyncTask(AsyncTask&& other) noexcept : handle(other.handle) {
+        other.handle = nullptr;
+    }
+
+    AsyncTask(const AsyncTask&) = delete;
+    AsyncTask& operator=(const AsyncTask&) = delete;
+    AsyncTask& operator=(AsyncTask&&) = delete;
+
+    /**
+     * @brief Destroys the coroutine.
+     */
+    ~AsyncTask() noexcept {
+        if(handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    coroutine_handle<> await_suspend(
+                                const coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+
+    T await_resume() {
+        promise_type& promise(handle.promise());
+        if(promise.exception) std::rethrow_exception(promise.exception);
+        return std::move(promise.value);
+    }
+
+    /**
+     * @brief Runs the coroutine, and blocks until it returns. Meanwhile, the
+     *        calling thread resumes the coroutines of the operation that have
+     *        no scheduler.
+     * 
+     * @retval T The returned value.
+     */
+    T Get() {
+        AsyncTrampoline trampoline;
+
+        handle.promise().onCompleted = [&trampoline]() {
+            trampoline.Complete();
+        };
+        handle.resume();
+        trampoline.Run();
+
+        return await_resume();
+    }
+};
+
+#endif /* LIST_HAS_COROUTINES */
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* ASYNC_TASK_H_ */
\ No newline at end of file
@@ -0,0 +1,480 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: Benchmark.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "../ConcurrentDoublyLinkedList.h"
+#include "../DelegatedList.h"
+#include "../DurableList.h"
+#include "../NumaNode.h"
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <string>
+#include <atomic>
+#include <cstdio>
+#include <algorithm>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::minstd_rand;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::atomic;
+using std::remove;
+using std::shuffle;
+
+/**=============================================================================
+ * Definitions:
+ * ===========================================================================*/
+
+typedef ConcurrentDoublyLinkedList List;
+
+/**
+ * @brief Enumeration type for the operations of the workload.
+ */
+enum Operation {INSERT_HEAD, DELETE, SEARCH};
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief Chooses the next operation of the workload: half of the operations
+ *        are searches, and the rest are split between insertions and
+ *        deletions, so the size of the list stays stable.
+ * 
+ * @param generator The generator of the calling thread.
+ * @param key       An output parameter, to which the key should be written.
+ * 
+ * @retval Operation The operation.
+ */
+Operation NextOperation(minstd_rand& generator, int* key);
+
+/**
+ * @brief Runs a task on THREADS_NUMBER threads, and measures its throughput.
+ * 
+ * @param task The task of a single thread, given the thread's index.
+ * 
+ * @retval double The number of operations per second.
+ */
+double Measure(const function<void(const unsigned int)>& task);
+
+/**
+ * @brief Runs a traversal TRAVERSALS_PER_THREAD times on THREADS_NUMBER
+ *        threads, and measures its throughput.
+ * 
+ * @param traversal A traversal of the whole list of LARGE_KEY_RANGE nodes.
+ * 
+ * @retval double The number of nodes traversed per second.
+ */
+double MeasureTraversals(const function<void()>& traversal);
+
+/**
+ * @brief Runs the workload on a list that uses the per-node lock protocol.
+ * 
+ * @retval double The number of operations per second.
+ */
+double RunLocked();
+
+/**
+ * @brief Runs the workload on a list that delegates the operations to owner
+ *        threads.
+ * 
+ * @retval double The number of operations per second.
+ */
+double RunDelegated();
+
+/**
+ * @brief Runs searches only, on a list that holds half of the keys, so the
+ *        throughput is that of the traversal (FindKey). Comparing builds with
+ *        and without LIST_CACHE_ALIGNED_NODES shows the effect of the node
+ *        layout, and comparing runs with and without ListOptions::isHugePaged
+ *        shows the effect of the pages under the nodes.
+ * 
+ * @param options The options of the list.
+ * 
+ * @retval double The number of operations per second.
+ */
+double RunSearches(const ListOptions& options);
+
+/**
+ * @brief Runs whole-list traversals on a list of LARGE_KEY_RANGE nodes, which
+ *        is larger than the last-level cache. The keys are inserted in a
+ *        shuffled order within blocks of SHUFFLED_BLOCK keys, so consecutive
+ *        nodes are not consecutive in memory, and the hardware prefetcher
+ *        cannot follow the list. Comparing PLAIN with PREFETCHING shows how
+ *        much of the misses the prefetches hide, in each direction and lock
+ *        mode.
+ * 
+ * @param policy       The traversal policy of the list.
+ * @param mayWriteRate An output parameter, to which the rate of deletions of
+ *                     a key beyond the last one (forward, in a may-write mode)
+ *                     should be written.
+ * @param backwardRate An output parameter, to which the rate of tail
+ *                     insertions of the first key (backward) should be
+ *                     written.
+ * 
+ * @retval double The rate of searches of the last key (forward, in a read
+ *                mode). All rates are in nodes traversed per second.
+ */
+double RunTraversals(const ListOptions::TraversalPolicy policy,
+                     double* mayWriteRate,
+                     double* backwardRate);
+
+/**
+ * @brief Runs searches on a list whose nodes are placed by a NUMA policy. The
+ *        key range is split between the NUMA nodes (see
+ *        ListOptions::numaRanges), the threads are pinned to the NUMA nodes in
+ *        turn, and each thread searches the keys of its own NUMA node. Every
+ *        SAMPLING_PERIOD-th search also checks where the found node lives.
+ * 
+ * @attention Traversals start at the head, so they still pass through the
+ *            ranges of lower NUMA nodes. Only the found nodes are sampled.
+ * 
+ * @param policy      The NUMA policy of the list.
+ * @param remoteRatio An output parameter, to which the ratio of the sampled
+ *                    nodes that were on another NUMA node than the searching
+ *                    thread should be written.
+ * 
+ * @retval double The number of operations per second.
+ */
+double RunNuma(const ListOptions::NumaPolicy policy, double* remoteRatio);
+
+/**
+ * @brief Runs the workload on a durable list (see DurableList), whose
+ *        insertions and deletions are logged with group commit, in files of
+ *        the working directory that are removed afterwards.
+ * 
+ * @param recordsPerSync An output parameter, to which the average number of
+ *                       logged operations per flush of the log should be
+ *                       written.
+ * 
+ * @retval double The number of operations per second.
+ */
+double RunDurable(double* recordsPerSync);
+
+/*==============================================================================
+ * Global Variables:
+ *============================================================================*/
+
+const unsigned int THREADS_NUMBER(8);
+const unsigned int OPERATIONS_PER_THREAD(20000);
+const unsigned int KEY_RANGE(1000);
+const unsigned int LARGE_KEY_RANGE(1U << 22);
+const unsigned int SHUFFLED_BLOCK(256);
+const unsigned int TRAVERSALS_PER_THREAD(1);
+const unsigned int OWNERS_NUMBER(4);
+const unsigned int SAMPLING_PERIOD(16);
+#ifdef LIST_CACHE_ALIGNED_NODES
+const string       NODE_LAYOUT("cache-aligned");
+#else
+const string       NODE_LAYOUT("packed");
+#endif
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+Operation NextOperation(minstd_rand& generator, int* key) {
+    *key = static_cast<int>(generator() % KEY_RANGE);
+    switch(generator() % 4) {
+        case 0:
+            return INSERT_HEAD;
+        case 1:
+            return DELETE;
+        default:
+            return SEARCH;
+    }
+}
+
+double Measure(const function<void(const unsigned int)>& task) {
+    vector<thread> threads;
+    threads.reserve(THREADS_NUMBER);
+
+    const steady_clock::time_point start(steady_clock::now());
+    for(unsigned int i = 0; i < THREADS_NUMBER; ++i) {
+        threads.emplace_back(task, i);
+    }
+    for(thread& worker : threads) {
+        worker.join();
+    }
+    const duration<double> elapsed(steady_clock::now() - start);
+
+    return THREADS_NUMBER * OPERATIONS_PER_THREAD / elapsed.count();
+}
+
+double RunLocked() {
+    List list;
+    return Measure([&list](const unsigned int index) {
+        minstd_rand generator(index + 1);
+        int key(0);
+        char data('0');
+        for(unsigned int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+            switch(NextOperation(generator, &key)) {
+                case INSERT_HEAD:
+                    list.InsertHead(key, data);
+                    break;
+                case DELETE:
+                    list.Delete(key);
+                    break;
+                default:
+                    list.Search(key, &data);
+            }
+        }
+    });
+}
+
+double RunDelegated() {
+    vector<int> boundaries;
+    for(unsigned int i = 1; i < OWNERS_NUMBER; ++i) {
+        boundaries.push_back(static_cast<int>(i * KEY_RANGE / OWNERS_NUMBER));
+    }
+
+    DelegatedList list(boundaries);
+    return Measure([&list](const unsigned int index) {
+        minstd_rand generator(index + 1);
+        int key(0);
+        char data('0');
+        for(unsigned int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+            switch(NextOperation(generator, &key)) {
+                case INSERT_HEAD:
+                    list.InsertHead(key, data).get();
+                    break;
+                case DELETE:
+                    list.Delete(key).get();
+                    break;
+                default:
+                    list.Search(key, &data).get();
+            }
+        }
+    });
+}
+
+double RunSearches(const ListOptions& options) {
+    List list(options);
+    for(unsigned int key = 0; key < KEY_RANGE; key += 2) {
+        list.InsertTail(static_cast<int>(key), '0');
+    }
+
+    return Measure([&list](const unsigned int index) {
+        minstd_rand generator(index + 1);
+        char data('0');
+        for(unsigned int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+            list.Search(static_cast<int>(generator() % KEY_RANGE), &data);
+        }
+    });
+}
+
+double MeasureTraversals(const function<void()>& traversal) {
+    vector<thread> threads;
+    threads.reserve(THREADS_NUMBER);
+
+    const steady_clock::time_point start(steady_clock::now());
+    for(unsigned int i = 0; i < THREADS_NUMBER; ++i) {
+        threads.emplace_back([&traversal]() {
+            for(unsigned int j = 0; j < TRAVERSALS_PER_THREAD; ++j) {
+                traversal();
+            }
+        });
+    }
+    for(thread& worker : threads) {
+        worker.join();
+    }
+    const duration<double> elapsed(steady_clock::now() - start);
+
+    return static_cast<double>(THREADS_NUMBER) * TRAVERSALS_PER_THREAD * \
+           LARGE_KEY_RANGE / elapsed.count();
+}
+
+double RunTraversals(const ListOptions::TraversalPolicy policy,
+                     double* mayWriteRate,
+                     double* backwardRate) {
+    ListOptions options;
+    options.traversalPolicy = policy;
+    List list(options);
+
+    // Each insertion walks back from the tail over the keys of its block
+    // that were already inserted.
+    minstd_rand generator(1);
+    vector<int> block(SHUFFLED_BLOCK);
+    for(unsigned int first = 0; first < LARGE_KEY_RANGE;
+                                                    first += SHUFFLED_BLOCK) {
+        for(unsigned int i = 0; i < SHUFFLED_BLOCK; ++i) {
+            block[i] = static_cast<int>(first + i);
+        }
+        shuffle(block.begin(), block.end(), generator);
+        for(const int key : block) {
+            list.InsertTail(key, '0');
+        }
+    }
+
+    const int lastKey(static_cast<int>(LARGE_KEY_RANGE) - 1);
+    *mayWriteRate = MeasureTraversals([&list, lastKey]() noexcept {
+        list.Delete(lastKey + 1);
+    });
+    *backwardRate = MeasureTraversals([&list]() {
+        list.InsertTail(0, '0');
+    });
+    return MeasureTraversals([&list, lastKey]() noexcept {
+        char data('0');
+        list.Search(lastKey, &data);
+    });
+}
+
+double RunNuma(const ListOptions::NumaPolicy policy, double* remoteRatio) {
+    const unsigned int nodesNumber(NumaNode::Count());
+    const unsigned int rangeSize(KEY_RANGE / nodesNumber);
+
+    ListOptions options;
+    options.numaPolicy = policy;
+    for(unsigned int node = 0; node < nodesNumber; ++node) {
+        options.numaRanges.push_back({static_cast<int>(node * rangeSize),
+                                      static_cast<int>(node)});
+    }
+
+    // With the default policy, all the nodes land on the NUMA node of this
+    // thread.
+    List list(options);
+    for(unsigned int key = 0; key < KEY_RANGE; key += 2) {
+        list.InsertTail(static_cast<int>(key), '0');
+    }
+
+    atomic<unsigned long> sampled(0), remote(0);
+    const double throughput(Measure([&](const unsigned int index) {
+        const int node(static_cast<int>(index % nodesNumber));
+        NumaNode::Pin(node);
+
+        minstd_rand generator(index + 1);
+        char data('0');
+        for(unsigned int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+            const int key(node * static_cast<int>(rangeSize) + \
+                          static_cast<int>(generator() % rangeSize));
+            if(list.Search(key, &data) && i % SAMPLING_PERIOD == 0) {
+                const int keyNode(list.NumaNodeOf(key));
+                if(keyNode < 0) continue;
+                ++sampled;
+                if(keyNode != NumaNode::Current()) ++remote;
+            }
+        }
+    }));
+
+    *remoteRatio = sampled == 0 ? 0 : static_cast<double>(remote) / \
+                                      static_cast<double>(sampled);
+    return throughput;
+}
+
+double RunDurable(double* recordsPerSync) {
+    const string snapshotPath("Benchmark.snapshot"), logPath("Benchmark.log");
+    remove(snapshotPath.c_str());
+    remove(logPath.c_str());
+
+    atomic<unsigned long> logged(0);
+    double throughput(0);
+    size_t syncsNumber(0);
+    {
+        DurableList list(snapshotPath, logPath);
+        throughput = Measure([&list, &logged](const unsigned int index) {
+            minstd_rand generator(index + 1);
+            int key(0);
+            char data('0');
+            for(unsigned int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+                DurableList::Result result(DurableList::FAILED);
+                switch(NextOperation(generator, &key)) {
+                    case INSERT_HEAD:
+                        result = list.InsertHead(key, data);
+                        break;
+                    case DELETE:
+                        result = list.Delete(key);
+                        break;
+                    default:
+                        list.Search(key, &data);
+                }
+                if(result == DurableList::SUCCEEDED) ++logged;
+            }
+        });
+        syncsNumber = list.SyncsNumber();
+    }
+
+    remove(snapshotPath.c_str());
+    remove(logPath.c_str());
+    *recordsPerSync = syncsNumber == 0 ? 0 : static_cast<double>(logged) / \
+                                             static_cast<double>(syncsNumber);
+    return throughput;
+}
+
+int main() {
+    cout << "Threads: " << THREADS_NUMBER << ", operations per thread: " << \
+            OPERATIONS_PER_THREAD << ", keys: " << KEY_RANGE << "." << endl;
+
+    cout << "Per-node locks: " << to_string(RunLocked()) << \
+            " operations per second." << endl;
+    cout << "Delegation (" << OWNERS_NUMBER << " owners): " << \
+            to_string(RunDelegated()) << " operations per second." << endl;
+    ListOptions hugePaged;
+    hugePaged.isHugePaged = true;
+    cout << "Searches only (" << NODE_LAYOUT << " nodes): " << \
+            to_string(RunSearches(ListOptions())) << \
+            " operations per second." << endl;
+    cout << "Searches only (" << NODE_LAYOUT << " nodes, huge pages): " << \
+            to_string(RunSearches(hugePaged)) << " operations per second." << \
+            endl;
+
+    for(const ListOptions::TraversalPolicy policy :
+                    {ListOptions::PLAIN, ListOptions::PREFETCHING}) {
+        double mayWriteRate(0), backwardRate(0);
+        const double readRate(RunTraversals(policy,
+                                            &mayWriteRate,
+                                            &backwardRate));
+        cout << "Traversals of " << LARGE_KEY_RANGE << " nodes (" << \
+                (policy == ListOptions::PLAIN ? "plain" : "prefetching") << \
+                "): " << to_string(readRate) << " forward reads, " << \
+                to_string(mayWriteRate) << " forward may-writes, " << \
+                to_string(backwardRate) << " backward, in nodes per " << \
+                "second." << endl;
+    }
+
+    double remoteRatio(0);
+    cout << "NUMA nodes: " << NumaNode::Count() << "." << endl;
+    const double defaultThroughput(RunNuma(ListOptions::NUMA_DEFAULT,
+                                           &remoteRatio));
+    cout << "Searches by NUMA range (default placement): " << \
+            to_string(defaultThroughput) << " operations per second, " << \
+            to_string(remoteRatio * 100) << "% remote." << endl;
+    const double byKeyThroughput(RunNuma(ListOptions::NUMA_BY_KEY,
+                                         &remoteRatio));
+    cout << "Searches by NUMA range (placed by key): " << \
+            to_string(byKeyThroughput) << " operations per second, " << \
+            to_string(remoteRatio * 100) << "% remote." << endl;
+
+    double recordsPerSync(0);
+    const double durableThroughput(RunDurable(&recordsPerSync));
+    cout << "Durable (write-ahead log): " << to_string(durableThroughput) << \
+            " operations per second, " << to_string(recordsPerSync) << \
+            " operations per flush." << endl;
+
+    return 0;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
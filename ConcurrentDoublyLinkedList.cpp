@@ -21,8 +21,26 @@
  * ===========================================================================*/
 
 #include "ConcurrentDoublyLinkedList.h"
+#include "ThreadSlot.h"
+#include "NumaNode.h"
+#include "Snapshot.h"
+#include <random>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cassert>
 
 using std::make_shared;
+using std::allocate_shared;
+using std::make_unique;
+using std::minstd_rand;
+using std::max;
+using std::min;
+using std::ofstream;
+using std::ios;
+using std::streamsize;
+using std::rename;
+using std::remove;
 
 /**=============================================================================
  * Declarations:
@@ -43,14 +61,60 @@ typedef ConcurrentDoublyLinkedList List;
 
 List::Node::Node(const int in_key,
                  const char in_data,
+                 List* const in_owner,
                  const NodePtr& in_prevPtr/* = nullptr*/,
-                 const NodePtr& in_nextPtr/* = nullptr*/) : key(in_key),
-                                                            data(in_data),
-                                                            prevPtr(in_prevPtr),
-                                                            nextPtr(in_nextPtr),
-                                                            isNodeActive(true) {
+                 const NodePtr& in_nextPtr/* = nullptr*/,
+                 const Kind in_kind/* = ENTRY*/) : kind(in_kind),
+                                                   isNodeActive(true),
+                                                   key(in_key),
+                                                   prevPtr(in_prevPtr),
+                                                   nextPtr(in_nextPtr),
+                                                   owner(in_owner),
+                                                   data(in_data),
+                                                   lock(in_owner->options
+                                                            .maxSpinRounds,
+                                                        in_owner->options
+                                                            .isReadBiased) {
 }
 
+#ifdef LIST_HAS_COROUTINES
+
+/*******************************************************************************
+ * ConcurrentDoublyLinkedList::LockAwaiter:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+bool List::LockAwaiter::await_suspend(const coroutine_handle<> handle) {
+    // Once the coroutine is enqueued, it may be resumed (and this awaiter
+    // destroyed) by another thread, so the awaiter is not touched afterwards.
+    // It is never resumed by the granting thread, which may hold other locks.
+    const AsyncScheduler* const resumer(scheduler);
+    AsyncTrampoline* const trampoline(AsyncTrampoline::Current());
+    assert(*resumer || trampoline != nullptr);
+    function<void()> onAcquired([handle, resumer, trampoline]() {
+        if(*resumer) {
+            (*resumer)(handle);
+        } else {
+            trampoline->Post(handle);
+        }
+    });
+
+    switch(mode) {
+        case READ:
+            return !lock.LockReadOrEnqueue(std::move(onAcquired));
+        case MAY_WRITE:
+            return !lock.LockMayWriteOrEnqueue(holder, std::move(onAcquired));
+        case WRITE:
+            return !lock.LockWriteOrEnqueue(std::move(onAcquired));
+        default:
+            return !lock.UpgradeLockOrEnqueue(holder, std::move(onAcquired));
+    }
+}
+
+#endif /* LIST_HAS_COROUTINES */
+
 /*******************************************************************************
  * ConcurrentDoublyLinkedList:
  ******************************************************************************/
@@ -58,6 +122,52 @@ List::Node::Node(const int in_key,
 /* private:
  **********/
 
+List::NodePtr List::NewNode(const int key,
+                            const char data,
+                            const NodePtr& prev,
+                            const NodePtr& next) {
+    if(nodeArenas.empty()) {
+        return make_shared<Node>(key, data, this, prev, next);
+    }
+
+    return allocate_shared<Node>(ArenaAllocator<Node>(
+                                            *nodeArenas[NumaNodeFor(key)]),
+                                 key,
+                                 data,
+                                 this,
+                                 prev,
+                                 next);
+}
+
+size_t List::NumaNodeFor(const int key) const noexcept {
+    if(options.numaPolicy == ListOptions::NUMA_DEFAULT) return 0;
+
+    int numaNode(NumaNode::Current());
+    if(options.numaPolicy == ListOptions::NUMA_BY_KEY) {
+        for(const ListOptions::NumaRange& range : options.numaRanges) {
+            if(range.lowestKey > key) break;
+            numaNode = range.numaNode;
+        }
+    }
+
+    return numaNode >= 0 && \
+           static_cast<size_t>(numaNode) < nodeArenas.size() ?
+               static_cast<size_t>(numaNode) :
+               0;
+}
+
+void List::Prefetch(const Node* const node) const noexcept {
+    if(options.traversalPolicy != ListOptions::PREFETCHING || \
+       node == nullptr) {
+        return;
+    }
+
+    // The key is read, and the lock word is written by the acquisition. In a
+    // packed node layout, the two may share a line.
+    __builtin_prefetch(node, 0);
+    __builtin_prefetch(&node->lock, 1);
+}
+
 void List::AdvanceAndLockReadMayWrite(NodePtr& prev,
                                       NodePtr& next,
                                       const bool isRead) const noexcept {
@@ -66,7 +176,12 @@ void List::AdvanceAndLockReadMayWrite(NodePtr& prev,
         next = prev->nextPtr;
         prev->lock.ReleaseSharedLock();
         next->lock.LockRead();
+        // The node after next is prefetched a whole hop before it is locked,
+        // as in the may-write mode.
+        Prefetch(next->nextPtr.get());
     } else {
+        // The lock of next is held, so its next pointer can be read already.
+        Prefetch(next->nextPtr.get());
         prev->lock.ReleaseSharedLock();
         prev = next;
         next = prev->nextPtr;
@@ -82,7 +197,11 @@ List::NodePtr List::FindKey(NodePtr& position,
         next->lock.LockMayWrite();
     }
 
-    while((next->key < key && next != tail) || next == head) {
+    // A reader may reach a removed node, as it does not hold the previous
+    // one. It passes it, in case the node was relocated (see Compact).
+    while(((next->key < key || !next->isNodeActive) && \
+           next->kind != Node::TAIL) || \
+          next->kind == Node::HEAD) {
         AdvanceAndLockReadMayWrite(prev, next, isRead);
     }
 
@@ -90,21 +209,70 @@ List::NodePtr List::FindKey(NodePtr& position,
     return next;
 }
 
+List::NodePtr List::TryFindKey(
+                    NodePtr& position,
+                    const int key,
+                    const bool isRead,
+                    const steady_clock::time_point deadline) const noexcept {
+    NodePtr prev(position), next(isRead ? position : position->nextPtr);
+    if(!isRead && !next->lock.TryLockMayWriteFor(TimeLeft(deadline))) {
+        prev->lock.ReleaseSharedLock();
+        return nullptr;
+    }
+
+    // See FindKey.
+    while(((next->key < key || !next->isNodeActive) && \
+           next->kind != Node::TAIL) || \
+          next->kind == Node::HEAD) {
+        if(isRead) {
+            prev = next;
+            next = prev->nextPtr;
+            prev->lock.ReleaseSharedLock();
+            if(!next->lock.TryLockReadFor(TimeLeft(deadline))) return nullptr;
+            Prefetch(next->nextPtr.get());
+        } else {
+            Prefetch(next->nextPtr.get());
+            prev->lock.ReleaseSharedLock();
+            prev = next;
+            next = prev->nextPtr;
+            if(!next->lock.TryLockMayWriteFor(TimeLeft(deadline))) {
+                prev->lock.ReleaseSharedLock();
+                return nullptr;
+            }
+        }
+    }
+
+    position = prev;
+    return next;
+}
+
+nanoseconds List::TimeLeft(const steady_clock::time_point deadline) noexcept {
+    return max(nanoseconds(deadline - steady_clock::now()),
+               nanoseconds::zero());
+}
+
 bool List::InsertFromPosition(const NodePtr& position,
                               const int key,
-                              const char data) {
+                              const char data,
+                              const bool shouldUpdate/* = false*/) {
     NodePtr prev(position);
     NodePtr next(FindKey(prev, key));
 
-    bool result(next->key != key || next == tail);
+    if(IsOutOfRange(prev, next, key)) {
+        prev->lock.ReleaseSharedLock();
+        next->lock.ReleaseSharedLock();
+        return false;
+    }
+
+    bool result(next->key != key || next->kind == Node::TAIL);
     if(result) {
-        prev->lock.UpgradeLock();
+        Link(prev, next, key, data);
+    } else if(shouldUpdate) {
+        prev->lock.ReleaseSharedLock();
         next->lock.UpgradeLock();
 
-        prev->nextPtr = make_shared<Node>(key, data, prev, next);
-        next->prevPtr = prev->nextPtr;
+        next->data = data;
 
-        prev->lock.ReleaseExclusiveLock();
         next->lock.ReleaseExclusiveLock();
     } else {
         prev->lock.ReleaseSharedLock();
@@ -114,13 +282,433 @@ bool List::InsertFromPosition(const NodePtr& position,
     return result;
 }
 
+bool List::IsOutOfRange(const NodePtr& prev,
+                        const NodePtr& next,
+                        const int key) noexcept {
+    // Keys out of the list's range are rejected, even if the list is currently
+    // empty there. They may belong to a list that got this list's nodes.
+    return (prev->kind == Node::HEAD && key < prev->key) || \
+           (next->kind == Node::TAIL && key > next->key);
+}
+
+void List::Link(const NodePtr& prev,
+                const NodePtr& next,
+                const int key,
+                const char data) {
+    prev->lock.UpgradeLock();
+    next->lock.UpgradeLock();
+
+    Attach(prev, next, key, data);
+
+    prev->lock.ReleaseExclusiveLock();
+    next->lock.ReleaseExclusiveLock();
+}
+
+void List::Attach(const NodePtr& prev,
+                  const NodePtr& next,
+                  const int key,
+                  const char data) {
+    // Everything that may throw comes before the node is linked, so the list
+    // is left unchanged if it does.
+    List& owner(*prev->owner);
+    const NodePtr node(owner.NewNode(key, data, prev, next));
+    if(owner.rankIndex != nullptr) owner.rankIndex->Add(key);
+
+    prev->nextPtr = node;
+    next->prevPtr = node;
+    owner.sizeCounter.Add(1);
+}
+
+List::NodePtr List::FindForModification(const int key) noexcept {
+    NodePtr prev(head);
+    prev->lock.LockMayWrite();
+    NodePtr next(FindKey(prev, key));
+    prev->lock.ReleaseSharedLock();
+
+    if(next->key != key || next->kind == Node::TAIL) {
+        next->lock.ReleaseSharedLock();
+        return nullptr;
+    }
+
+    return next;
+}
+
+List::NodePtr List::FindForRead(const int key) const noexcept {
+    NodePtr prev(head);
+    prev->lock.LockRead();
+    const NodePtr node(FindKey(prev, key, /*isRead = */true));
+
+    if(node->key != key || !node->isNodeActive || node->kind == Node::TAIL) {
+        node->lock.ReleaseSharedLock();
+        return nullptr;
+    }
+
+    return node;
+}
+
+void List::Unlink(const NodePtr& prev, const NodePtr& del) noexcept {
+    prev->lock.UpgradeLock();
+    del->lock.UpgradeLock();
+
+    const NodePtr next(del->nextPtr);
+    next->lock.LockWrite();
+
+    Detach(prev, del, next);
+
+    prev->lock.ReleaseExclusiveLock();
+    del->lock.ReleaseExclusiveLock();
+    next->lock.ReleaseExclusiveLock();
+}
+
+void List::Detach(const NodePtr& prev,
+                  const NodePtr& del,
+                  const NodePtr& next) noexcept {
+    prev->nextPtr = next;
+    next->prevPtr = prev;
+    del->isNodeActive = false;
+    List& owner(*del->owner);
+    owner.sizeCounter.Add(-1);
+    if(owner.rankIndex != nullptr) owner.rankIndex->Remove(del->key);
+}
+
+#ifdef LIST_HAS_COROUTINES
+
+// GCC warns about the switch statements it generates for coroutines.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-default"
+
+AsyncTask<List::NodePtr> List::FindKeyAsync(NodePtr& position,
+                                            const int key,
+                                            const void* const holder,
+                                            const AsyncScheduler& scheduler) {
+    NodePtr prev(position), next(position->nextPtr);
+    co_await LockAwaiter{next->lock,
+                         LockAwaiter::MAY_WRITE,
+                         holder,
+                         &scheduler};
+
+    // As in FindKey.
+    while(((next->key < key || !next->isNodeActive) && \
+           next->kind != Node::TAIL) || \
+          next->kind == Node::HEAD) {
+        // The owner of next can be read, as its lock is held in a may-write
+        // mode.
+        next->owner->Prefetch(next->nextPtr.get());
+        prev->lock.ReleaseSharedLock(holder);
+        prev = next;
+        next = prev->nextPtr;
+        co_await LockAwaiter{next->lock,
+                             LockAwaiter::MAY_WRITE,
+                             holder,
+                             &scheduler};
+    }
+
+    position = prev;
+    co_return next;
+}
+
+#pragma GCC diagnostic pop
+
+#endif /* LIST_HAS_COROUTINES */
+
+void List::ApplySortedBatch(BatchRequest* const* requests,
+                            const size_t count) {
+    NodePtr position(head);
+    position->lock.LockMayWrite();
+
+    for(size_t i = 0; i < count; ++i) {
+        BatchRequest& request(*requests[i]);
+        NodePtr next(FindKey(position, request.key));
+        const bool isFound(next->key == request.key && \
+                           next->kind != Node::TAIL);
+
+        bool isModifying(false);
+        switch(request.type) {
+            case BatchRequest::INSERT:
+                isModifying = !isFound && \
+                              !IsOutOfRange(position, next, request.key);
+                request.result = isModifying;
+                if(isModifying) Link(position, next, request.key, request.data);
+                break;
+            case BatchRequest::DELETE:
+                isModifying = isFound;
+                request.result = isModifying;
+                if(isModifying) Unlink(position, next);
+                break;
+            case BatchRequest::SEARCH:
+                request.result = isFound;
+                if(isFound) request.data = next->data;
+                break;
+            default:
+                request.result = false;
+                break;
+        }
+
+        if(!isModifying) {
+            next->lock.ReleaseSharedLock();
+            continue;
+        }
+
+        // The locks were released by the modification. The position is still
+        // lower than the next keys, so the sweep goes on from it if it was not
+        // deleted meanwhile.
+        position->lock.LockMayWrite();
+        if(!position->isNodeActive) {
+            position->lock.ReleaseSharedLock();
+            position = head;
+            position->lock.LockMayWrite();
+        }
+    }
+
+    position->lock.ReleaseSharedLock();
+}
+
+void List::ApplySortedBatchExclusively(BatchRequest* const* requests,
+                                       const size_t count) {
+    // No other thread removes or relocates nodes, so the sweep never meets an
+    // inactive node, and its position stays in the list.
+    NodePtr position(head);
+
+    for(size_t i = 0; i < count; ++i) {
+        BatchRequest& request(*requests[i]);
+        NodePtr next(position->nextPtr);
+        while(next->key < request.key && next->kind != Node::TAIL) {
+            Prefetch(next->nextPtr.get());
+            position = next;
+            next = position->nextPtr;
+        }
+        const bool isFound(next->key == request.key && \
+                           next->kind != Node::TAIL);
+
+        switch(request.type) {
+            case BatchRequest::INSERT:
+                request.result = !isFound && \
+                                 !IsOutOfRange(position, next, request.key);
+                if(request.result) {
+                    Attach(position, next, request.key, request.data);
+                }
+                break;
+            case BatchRequest::DELETE:
+                request.result = isFound;
+                if(isFound) Detach(position, next, next->nextPtr);
+                break;
+            case BatchRequest::SEARCH:
+                request.result = isFound;
+                if(isFound) request.data = next->data;
+                break;
+            default:
+                request.result = false;
+                break;
+        }
+    }
+}
+
+unsigned int List::RandomSprayOffset(const unsigned int width) noexcept {
+    if(width <= 1) return 0;
+
+    static thread_local minstd_rand generator(ThreadSlot::Index() + 1);
+    return static_cast<unsigned int>(generator() % width);
+}
+
+List::NodePtr List::LockLastAndTail(const NodePtr& held) noexcept {
+    while(true) {
+        tail->lock.LockRead();
+        const NodePtr last(tail->prevPtr);
+        tail->lock.ReleaseSharedLock(); // Not holding any lock now. Mandatory,
+                                        // if we don't want to be deadlocked.
+
+        // Nothing can be inserted after a held node, nor can it be deleted, so
+        // if it was the last one, it still is.
+        if(last != held) {
+            last->lock.LockMayWrite();
+            if(!last->isNodeActive || last->nextPtr != tail) {
+                last->lock.ReleaseSharedLock();
+                continue;
+            }
+        }
+
+        tail->lock.LockMayWrite();
+        return last;
+    }
+}
+
+void List::MoveOwnership(NodePtr node, List& newOwner) noexcept {
+    bool isExclusive(true);
+    while(true) {
+        List& oldOwner(*node->owner);
+        if(&oldOwner != &newOwner) {
+            oldOwner.sizeCounter.Add(-1);
+            newOwner.sizeCounter.Add(1);
+            if(oldOwner.rankIndex != nullptr) {
+                oldOwner.rankIndex->Remove(node->key);
+            }
+            if(newOwner.rankIndex != nullptr) {
+                newOwner.rankIndex->Add(node->key);
+            }
+            node->owner = &newOwner;
+        }
+
+        const NodePtr next(node->nextPtr);
+        const bool isLast(next->kind == Node::TAIL);
+        if(!isLast) next->lock.LockMayWrite();
+
+        if(isExclusive) {
+            node->lock.ReleaseExclusiveLock();
+            isExclusive = false;
+        } else {
+            node->lock.ReleaseSharedLock();
+        }
+
+        if(isLast) return;
+        node = next;
+    }
+}
+
+void List::SplitInto(const int key,
+                     List& other,
+                     const function<void()>& onSwitch) {
+    NodePtr prev(head);
+    prev->lock.LockMayWrite();
+    NodePtr next(FindKey(prev, key));
+
+    const bool isMoving(next->kind != Node::TAIL);
+    const NodePtr last(isMoving ? LockLastAndTail(next) : next);
+
+    prev->lock.UpgradeLock();
+    next->lock.UpgradeLock();
+    if(last != next) last->lock.UpgradeLock();
+    if(isMoving) tail->lock.UpgradeLock();
+    other.head->lock.LockWrite();
+    other.tail->lock.LockWrite();
+
+    if(isMoving) {
+        other.head->nextPtr = next;
+        next->prevPtr = other.head;
+        last->nextPtr = other.tail;
+        other.tail->prevPtr = last;
+        prev->nextPtr = tail;
+        tail->prevPtr = prev;
+    }
+    if(key <= head->key) { // All the range is moved.
+        other.head->key = head->key;
+        other.tail->key = tail->key;
+        head->key = numeric_limits<int>::max();
+        tail->key = numeric_limits<int>::min();
+    } else if(key > tail->key) { // None of the range is moved.
+        other.head->key = numeric_limits<int>::max();
+        other.tail->key = numeric_limits<int>::min();
+    } else {
+        other.head->key = key;
+        other.tail->key = tail->key;
+        tail->key = key - 1;
+    }
+
+    onSwitch();
+
+    prev->lock.ReleaseExclusiveLock();
+    if(last != next) last->lock.ReleaseExclusiveLock();
+    if(isMoving) tail->lock.ReleaseExclusiveLock();
+    other.head->lock.ReleaseExclusiveLock();
+    other.tail->lock.ReleaseExclusiveLock();
+
+    if(isMoving) {
+        MoveOwnership(next, other);
+    } else {
+        next->lock.ReleaseExclusiveLock();
+    }
+}
+
+bool List::AppendFrom(List& other,
+                      const bool shouldRetire,
+                      const function<void()>& onSwitch) {
+    const NodePtr last(LockLastAndTail(nullptr));
+    other.head->lock.LockMayWrite();
+    const NodePtr first(other.head->nextPtr);
+    first->lock.LockMayWrite();
+
+    const bool isMoving(first->kind != Node::TAIL);
+    const NodePtr otherLast(isMoving ? other.LockLastAndTail(first) : first);
+
+    if(isMoving && last->kind == Node::ENTRY && first->key <= last->key) {
+        last->lock.ReleaseSharedLock();
+        tail->lock.ReleaseSharedLock();
+        other.head->lock.ReleaseSharedLock();
+        first->lock.ReleaseSharedLock();
+        if(otherLast != first) otherLast->lock.ReleaseSharedLock();
+        other.tail->lock.ReleaseSharedLock();
+        return false;
+    }
+
+    last->lock.UpgradeLock();
+    tail->lock.UpgradeLock();
+    other.head->lock.UpgradeLock();
+    first->lock.UpgradeLock();
+    if(otherLast != first) otherLast->lock.UpgradeLock();
+    if(isMoving) other.tail->lock.UpgradeLock();
+
+    if(isMoving) {
+        last->nextPtr = first;
+        first->prevPtr = last;
+        otherLast->nextPtr = tail;
+        tail->prevPtr = otherLast;
+        other.head->nextPtr = other.tail;
+        other.tail->prevPtr = other.head;
+    }
+    tail->key = max(tail->key, other.tail->key);
+    if(last == head) head->key = min(head->key, other.head->key);
+    if(shouldRetire) {
+        other.head->key = numeric_limits<int>::max();
+        other.tail->key = numeric_limits<int>::min();
+    }
+
+    onSwitch();
+
+    last->lock.ReleaseExclusiveLock();
+    tail->lock.ReleaseExclusiveLock();
+    other.head->lock.ReleaseExclusiveLock();
+    if(otherLast != first) otherLast->lock.ReleaseExclusiveLock();
+    if(isMoving) other.tail->lock.ReleaseExclusiveLock();
+
+    if(isMoving) {
+        MoveOwnership(first, *this);
+    } else {
+        first->lock.ReleaseExclusiveLock();
+    }
+
+    return true;
+}
+
 /* public:
  *********/
 
-List::ConcurrentDoublyLinkedList() : head(make_shared<Node>(0, '0')),
-                                     tail(make_shared<Node>(0, '0')) {
+List::ConcurrentDoublyLinkedList(const ListOptions& in_options/* = {}*/) :
+            options(in_options),
+            head(make_shared<Node>(options.lowestKey,
+                                   '0',
+                                   this,
+                                   nullptr,
+                                   nullptr,
+                                   Node::HEAD)),
+            tail(make_shared<Node>(options.highestKey,
+                                   '0',
+                                   this,
+                                   nullptr,
+                                   nullptr,
+                                   Node::TAIL)),
+            rankIndex(options.isRankIndexed ? make_unique<KeyRankIndex>() :
+                                              nullptr) {
     head->nextPtr = tail;
     tail->prevPtr = head;
+
+    if(options.numaPolicy != ListOptions::NUMA_DEFAULT) {
+        for(unsigned int i = 0; i < NumaNode::Count(); ++i) {
+            nodeArenas.push_back(make_unique<NodeArena>(static_cast<int>(i),
+                                                        options.isHugePaged));
+        }
+    } else if(options.isHugePaged) {
+        nodeArenas.push_back(make_unique<NodeArena>(/*numaNode = */-1,
+                                                    /*isHugePaged = */true));
+    }
 }
 
 List::~ConcurrentDoublyLinkedList() {
@@ -144,16 +732,21 @@ bool List::InsertTail(const int key, const char data) {
     next->lock.ReleaseSharedLock(); // Not holding any lock now. Mandatory, if
                                     // we don't want to be deadlocked.
     prev->lock.LockMayWrite();
+    Prefetch(prev->prevPtr.get());
 
-    while((prev->key > key && prev != head) || !prev->isNodeActive) {
+    // The node before prev is prefetched as soon as prev is locked, a whole
+    // hop before it is locked itself.
+    while((prev->key > key && prev->kind != Node::HEAD) || \
+          !prev->isNodeActive) {
         next = prev;
         prev = next->prevPtr;
         next->lock.ReleaseSharedLock(); // Not holding any lock now. Mandatory,
                                         // if we don't want to be deadlocked.
         prev->lock.LockMayWrite();
+        Prefetch(prev->prevPtr.get());
     }
 
-    if(prev != head && prev->key == key){
+    if(prev->kind != Node::HEAD && prev->key == key){
         prev->lock.ReleaseSharedLock();
         return false;
     }
@@ -166,46 +759,647 @@ bool List::Delete(const int key) noexcept {
     prev->lock.LockMayWrite();
     NodePtr next(FindKey(prev, key));
 
-    bool result(next->key == key && next != tail);
+    bool result(next->key == key && next->kind != Node::TAIL);
+    if(result) {
+        Unlink(prev, next);
+    } else {
+        prev->lock.ReleaseSharedLock();
+        next->lock.ReleaseSharedLock();
+    }
+
+    return result;
+}
+
+bool List::Upsert(const int key, const char data) {
+    head->lock.LockMayWrite();
+
+    return InsertFromPosition(head, key, data, /*shouldUpdate = */true);
+}
+
+bool List::InsertAndScan(const int key,
+                         const char data,
+                         const function<bool(const int,
+                                             const char)>& visitor) {
+    NodePtr prev(head);
+    prev->lock.LockMayWrite();
+    NodePtr next(FindKey(prev, key));
+
+    if(IsOutOfRange(prev, next, key)) {
+        prev->lock.ReleaseSharedLock();
+        next->lock.ReleaseSharedLock();
+        return false;
+    }
+
+    const bool result(next->key != key || next->kind == Node::TAIL);
     if(result) {
         prev->lock.UpgradeLock();
         next->lock.UpgradeLock();
 
-        NodePtr del(next);
-        next = del->nextPtr;
-        next->lock.LockWrite();
+        Attach(prev, next, key, data);
 
-        prev->nextPtr = next;
-        next->prevPtr = prev;
-        del->isNodeActive = false;
+        // The new node can be reached only through prev and next, whose locks
+        // are held in a write mode, so it is visited without its lock.
+        const bool shouldContinue(visitor(key, data));
 
         prev->lock.ReleaseExclusiveLock();
-        del->lock.ReleaseExclusiveLock();
-        next->lock.ReleaseExclusiveLock();
+        next->lock.DowngradeToMayWrite();
+        next->lock.DowngradeToRead();
+        if(!shouldContinue) {
+            next->lock.ReleaseSharedLock();
+            return result;
+        }
     } else {
         prev->lock.ReleaseSharedLock();
-        next->lock.ReleaseSharedLock();
+        next->lock.DowngradeToRead();
     }
 
+    // A read scan, holding one lock at a time.
+    while(next->kind != Node::TAIL) {
+        if(next->isNodeActive && !visitor(next->key, next->data)) break;
+
+        prev = next;
+        next = prev->nextPtr;
+        prev->lock.ReleaseSharedLock();
+        next->lock.LockRead();
+    }
+    next->lock.ReleaseSharedLock();
+
     return result;
 }
 
+bool List::Update(const int key, const char data) noexcept {
+    const NodePtr node(FindForModification(key));
+    if(node == nullptr) return false;
+
+    node->lock.UpgradeLock();
+    node->data = data;
+    node->lock.ReleaseExclusiveLock();
+
+    return true;
+}
+
+bool List::CompareAndSwapValue(const int key,
+                               const char expected,
+                               const char desired) noexcept {
+    const NodePtr node(FindForRead(key));
+    if(node == nullptr) return false;
+
+    char current(expected);
+    const bool result(node->data.compare_exchange_strong(current, desired));
+    node->lock.ReleaseSharedLock();
+
+    return result;
+}
+
+bool List::FetchAdd(const int key,
+                    const char delta,
+                    char* previous/* = nullptr*/) noexcept {
+    const NodePtr node(FindForRead(key));
+    if(node == nullptr) return false;
+
+    const char old(node->data.fetch_add(delta));
+    node->lock.ReleaseSharedLock();
+
+    if(previous != nullptr) *previous = old;
+    return true;
+}
+
+bool List::Apply(const int key,
+                 const function<char(const char)>& modifier,
+                 char* previous/* = nullptr*/) {
+    const NodePtr node(FindForRead(key));
+    if(node == nullptr) return false;
+
+    char current(node->data.load());
+    while(!node->data.compare_exchange_weak(current, modifier(current))) {
+        // On failure, current is updated to the data written concurrently.
+    }
+    node->lock.ReleaseSharedLock();
+
+    if(previous != nullptr) *previous = current;
+    return true;
+}
+
 bool List::Search(const int key, char* data) const noexcept {
     if(data == nullptr) return false;
 
+    const NodePtr node(FindForRead(key));
+    if(node == nullptr) return false;
+
+    *data = node->data.load();
+    node->lock.ReleaseSharedLock();
+
+    return true;
+}
+
+List::TryResult List::TryInsert(const int key,
+                                const char data,
+                                const nanoseconds timeout) {
+    const steady_clock::time_point deadline(steady_clock::now() + timeout);
+
+    NodePtr prev(head);
+    if(!prev->lock.TryLockMayWriteFor(timeout)) return TIMED_OUT;
+    const NodePtr next(TryFindKey(prev, key, /*isRead = */false, deadline));
+    if(next == nullptr) return TIMED_OUT;
+
+    if(IsOutOfRange(prev, next, key) || \
+       (next->key == key && next->kind != Node::TAIL)) {
+        prev->lock.ReleaseSharedLock();
+        next->lock.ReleaseSharedLock();
+        return FAILED;
+    }
+
+    if(!prev->lock.TryUpgradeLockFor(TimeLeft(deadline))) {
+        prev->lock.ReleaseSharedLock();
+        next->lock.ReleaseSharedLock();
+        return TIMED_OUT;
+    }
+    if(!next->lock.TryUpgradeLockFor(TimeLeft(deadline))) {
+        prev->lock.ReleaseExclusiveLock();
+        next->lock.ReleaseSharedLock();
+        return TIMED_OUT;
+    }
+
+    Attach(prev, next, key, data);
+
+    prev->lock.ReleaseExclusiveLock();
+    next->lock.ReleaseExclusiveLock();
+
+    return SUCCEEDED;
+}
+
+List::TryResult List::TrySearch(const int key,
+                                char* data,
+                                const nanoseconds timeout) const noexcept {
+    if(data == nullptr) return FAILED;
+
+    const steady_clock::time_point deadline(steady_clock::now() + timeout);
+
+    NodePtr prev(head);
+    if(!prev->lock.TryLockReadFor(timeout)) return TIMED_OUT;
+    const NodePtr node(TryFindKey(prev, key, /*isRead = */true, deadline));
+    if(node == nullptr) return TIMED_OUT;
+
+    const bool isFound(node->key == key && node->isNodeActive && \
+                       node->kind != Node::TAIL);
+    if(isFound) {
+        *data = node->data.load();
+    }
+    node->lock.ReleaseSharedLock();
+
+    return isFound ? SUCCEEDED : FAILED;
+}
+
+bool List::PopMin(int* key,
+                  char* data,
+                  const unsigned int sprayWidth/* = 1*/) noexcept {
+    if(key == nullptr || data == nullptr) return false;
+
+    NodePtr prev(head);
+    prev->lock.LockMayWrite();
+    NodePtr next(prev->nextPtr);
+    next->lock.LockMayWrite();
+
+    if(next->kind == Node::TAIL) {
+        prev->lock.ReleaseSharedLock();
+        next->lock.ReleaseSharedLock();
+        return false;
+    }
+
+    // The head is held in a may-write mode only while passing through it, so
+    // popping threads that chose different offsets upgrade different locks.
+    const unsigned int offset(RandomSprayOffset(sprayWidth));
+    for(unsigned int i = 0;
+        i < offset && next->nextPtr->kind != Node::TAIL;
+        ++i) {
+        AdvanceAndLockReadMayWrite(prev, next, /*isRead = */false);
+    }
+
+    *key = next->key;
+    *data = next->data.load();
+    Unlink(prev, next);
+
+    return true;
+}
+
+bool List::PopMax(int* key,
+                  char* data,
+                  const unsigned int sprayWidth/* = 1*/) noexcept {
+    if(key == nullptr || data == nullptr) return false;
+
+    while(true) {
+        tail->lock.LockRead();
+        NodePtr candidate(tail->prevPtr);
+        tail->lock.ReleaseSharedLock(); // Not holding any lock now. Mandatory,
+                                        // if we don't want to be deadlocked.
+        if(candidate == head) return false;
+
+        // Going backwards, only one lock is held at a time, in a read mode,
+        // just for reading the previous pointer.
+        const unsigned int offset(RandomSprayOffset(sprayWidth));
+        NodePtr prev;
+        bool isCandidateActive(true);
+        for(unsigned int i = 0; ; ++i) {
+            candidate->lock.LockRead();
+            prev = candidate->prevPtr;
+            isCandidateActive = candidate->isNodeActive;
+            Prefetch(prev.get());
+            candidate->lock.ReleaseSharedLock();
+
+            if(!isCandidateActive || i >= offset || prev->kind == Node::HEAD) {
+                break;
+            }
+            candidate = prev;
+        }
+        if(!isCandidateActive) continue;
+
+        // Now locking in the usual order, and validating that nothing changed
+        // in the meantime. Otherwise, starting over.
+        prev->lock.LockMayWrite();
+        if(prev->isNodeActive && prev->nextPtr == candidate) {
+            candidate->lock.LockMayWrite();
+            // A candidate that moved to another list is not popped from this
+            // one.
+            if(candidate->owner == this && \
+               (offset > 0 || candidate->nextPtr == tail)) {
+                *key = candidate->key;
+                *data = candidate->data.load();
+                Unlink(prev, candidate);
+                return true;
+            }
+            candidate->lock.ReleaseSharedLock();
+        }
+        prev->lock.ReleaseSharedLock();
+    }
+}
+
+void List::Scan(const int key,
+                const function<bool(const int, const char)>& visitor) const {
     NodePtr prev(head);
     prev->lock.LockRead();
-    const NodePtr node(FindKey(prev, key, /*isRead = */true));
+    NodePtr next(FindKey(prev, key, /*isRead = */true));
 
-    bool result(node->key == key && node->isNodeActive && node != tail);
-    if(result) {
-        *data = node->data;
+    // As the read scan of InsertAndScan.
+    while(next->kind != Node::TAIL) {
+        if(next->isNodeActive && !visitor(next->key, next->data)) break;
+
+        prev = next;
+        next = prev->nextPtr;
+        prev->lock.ReleaseSharedLock();
+        next->lock.LockRead();
+    }
+    next->lock.ReleaseSharedLock();
+}
+
+bool List::PeekMin(int* key, char* data) const noexcept {
+    if(key == nullptr || data == nullptr) return false;
+
+    while(true) {
+        head->lock.LockRead();
+        const NodePtr node(head->nextPtr);
+        head->lock.ReleaseSharedLock();
+        if(node->kind == Node::TAIL) return false;
+
+        node->lock.LockRead();
+        const bool isNodeActive(node->isNodeActive);
+        if(isNodeActive) {
+            *key = node->key;
+            *data = node->data.load();
+        }
+        node->lock.ReleaseSharedLock();
+
+        if(isNodeActive) return true;
+    }
+}
+
+bool List::PeekMax(int* key, char* data) const noexcept {
+    if(key == nullptr || data == nullptr) return false;
+
+    while(true) {
+        tail->lock.LockRead();
+        const NodePtr node(tail->prevPtr);
+        tail->lock.ReleaseSharedLock();
+        if(node->kind == Node::HEAD) return false;
+
+        node->lock.LockRead();
+        const bool isNodeActive(node->isNodeActive);
+        if(isNodeActive) {
+            *key = node->key;
+            *data = node->data.load();
+        }
+        node->lock.ReleaseSharedLock();
+
+        if(isNodeActive) return true;
+    }
+}
+
+size_t List::Size() const noexcept {
+    const long size(sizeCounter.Sum());
+    // Concurrent updates may be seen partially, so the sum can even be
+    // negative for a moment.
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+size_t List::ApproximateSize() const noexcept {
+    const long size(sizeCounter.ApproximateSum());
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+size_t List::Rank(const int key) const noexcept {
+    if(rankIndex != nullptr) return rankIndex->Rank(key);
+
+    size_t rank(0);
+    NodePtr prev(head), next(head);
+    next->lock.LockRead();
+    AdvanceAndLockReadMayWrite(prev, next, /*isRead = */true);
+    while(next->key < key && next->kind != Node::TAIL) {
+        if(next->isNodeActive) ++rank;
+        AdvanceAndLockReadMayWrite(prev, next, /*isRead = */true);
     }
+    next->lock.ReleaseSharedLock();
+
+    return rank;
+}
+
+bool List::Select(const size_t index, int* key) const noexcept {
+    if(key == nullptr) return false;
+    if(rankIndex != nullptr) return rankIndex->Select(index, key);
+
+    size_t position(0);
+    NodePtr prev(head), next(head);
+    next->lock.LockRead();
+    AdvanceAndLockReadMayWrite(prev, next, /*isRead = */true);
+    while(next->kind != Node::TAIL && \
+          (!next->isNodeActive || position < index)) {
+        if(next->isNodeActive) ++position;
+        AdvanceAndLockReadMayWrite(prev, next, /*isRead = */true);
+    }
+
+    const bool result(next->kind != Node::TAIL);
+    if(result) *key = next->key;
+    next->lock.ReleaseSharedLock();
+
+    return result;
+}
+
+unique_ptr<List> List::SplitAt(const int key) {
+    unique_ptr<List> other(make_unique<List>(options));
+    SplitInto(key, *other, []() noexcept {});
+    return other;
+}
+
+bool List::Splice(List& other) {
+    if(&other == this) return false;
+    return AppendFrom(other, /*shouldRetire = */false, []() noexcept {});
+}
+
+size_t List::Compact() {
+    // With a NUMA policy, the copies are packed per NUMA node.
+    vector<unique_ptr<NodeArena>> arenas(max<size_t>(nodeArenas.size(), 1));
+    size_t relocated(0);
+
+    NodePtr prev(head);
+    prev->lock.LockMayWrite();
+    NodePtr node(prev->nextPtr);
+    node->lock.LockMayWrite();
+    while(node->kind != Node::TAIL) {
+        prev->lock.UpgradeLock();
+        node->lock.UpgradeLock();
+        const NodePtr next(node->nextPtr);
+        next->lock.LockWrite();
+
+        const size_t numaNode(NumaNodeFor(node->key));
+        if(arenas[numaNode] == nullptr) {
+            arenas[numaNode] = make_unique<NodeArena>(
+                   options.numaPolicy == ListOptions::NUMA_DEFAULT ?
+                       -1 :
+                       static_cast<int>(numaNode),
+                   options.isHugePaged);
+        }
+
+        const NodePtr copy(allocate_shared<Node>(ArenaAllocator<Node>(
+                                                        *arenas[numaNode]),
+                                                 node->key,
+                                                 node->data.load(),
+                                                 node->owner,
+                                                 prev,
+                                                 next));
+        copy->lock.LockMayWrite(); // No one else can reach it yet.
+        prev->nextPtr = copy;
+        next->prevPtr = copy;
+        node->nextPtr = copy;
+        node->isNodeActive = false;
+        ++relocated;
+
+        // The accounting (size counter and rank index) is unchanged, as the
+        // key stays in the list.
+        prev->lock.ReleaseExclusiveLock();
+        node->lock.ReleaseExclusiveLock();
+        next->lock.DowngradeToMayWrite();
+        prev = copy;
+        node = next;
+    }
+
+    prev->lock.ReleaseSharedLock();
     node->lock.ReleaseSharedLock();
+    return relocated;
+}
+
+int List::NumaNodeOf(const int key) const noexcept {
+    const NodePtr node(FindForRead(key));
+    if(node == nullptr) return -1;
+
+    const int numaNode(NumaNode::Of(node.get()));
+    node->lock.ReleaseSharedLock();
+    return numaNode;
+}
+
+bool List::SaveSnapshot(const string& path) const {
+    const string temporaryPath(path + ".tmp");
+    ofstream file(temporaryPath, ios::binary | ios::trunc);
+    if(!file) return false;
+
+    // The header is written again when the count and the checksum are known.
+    Snapshot::Header header{Snapshot::MAGIC,
+                            Snapshot::VERSION,
+                            0,
+                            0,
+                            Snapshot::CHECKSUM_SEED};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // The keys are streamed, and the data follows them.
+    vector<char> data;
+    NodePtr prev(head), next(head);
+    next->lock.LockRead();
+    AdvanceAndLockReadMayWrite(prev, next, /*isRead = */true);
+    while(next->kind != Node::TAIL) {
+        if(next->isNodeActive) {
+            const int key(next->key);
+            file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+            header.checksum = Snapshot::Checksum(&key,
+                                                 sizeof(key),
+                                                 header.checksum);
+            data.push_back(next->data.load());
+        }
+        AdvanceAndLockReadMayWrite(prev, next, /*isRead = */true);
+    }
+    next->lock.ReleaseSharedLock();
+
+    header.count = data.size();
+    header.checksum = Snapshot::Checksum(data.data(),
+                                         data.size(),
+                                         header.checksum);
+    file.write(data.data(), static_cast<streamsize>(data.size()));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    // The contents are flushed before the rename, and the rename after it, so
+    // a crash leaves either the old file or the complete new one.
+    if(!file || !Snapshot::Sync(temporaryPath) || \
+       rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        remove(temporaryPath.c_str());
+        return false;
+    }
+
+    return Snapshot::SyncDirectory(path);
+}
+
+bool List::LoadSnapshot(const string& path) {
+    vector<int> keys;
+    vector<char> data;
+    if(!Snapshot::Read(path, &keys, &data)) return false;
+
+    head->lock.LockWrite();
+    tail->lock.LockWrite();
+
+    // The keys are sorted, so checking the first and the last is enough.
+    const bool result(head->nextPtr == tail && \
+                      (keys.empty() || (keys.front() >= head->key && \
+                                        keys.back() <= tail->key)));
+    if(result) {
+        // No one can pass the head, so the nodes are linked without locks.
+        NodePtr prev(head);
+        for(size_t i = 0; i < keys.size(); ++i) {
+            const NodePtr node(NewNode(keys[i], data[i], prev, tail));
+            if(rankIndex != nullptr) rankIndex->Add(keys[i]);
+            prev->nextPtr = node;
+            prev = node;
+        }
+        tail->prevPtr = prev;
+        sizeCounter.Add(static_cast<long>(keys.size()));
+    }
+
+    head->lock.ReleaseExclusiveLock();
+    tail->lock.ReleaseExclusiveLock();
 
     return result;
 }
 
+#ifdef LIST_HAS_COROUTINES
+
+// See FindKeyAsync.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-default"
+
+AsyncTask<bool> List::InsertAsync(const int key,
+                                  const char data,
+                                  AsyncScheduler scheduler/* = nullptr*/) {
+    // An address in the coroutine's frame identifies the operation as the
+    // may-writer of its locks, as it may move between threads.
+    const char token(0);
+    const void* const holder(&token);
+
+    NodePtr prev(head);
+    co_await LockAwaiter{prev->lock,
+                         LockAwaiter::MAY_WRITE,
+                         holder,
+                         &scheduler};
+    const NodePtr next(co_await FindKeyAsync(prev, key, holder, scheduler));
+
+    if(IsOutOfRange(prev, next, key) || \
+       (next->key == key && next->kind != Node::TAIL)) {
+        prev->lock.ReleaseSharedLock(holder);
+        next->lock.ReleaseSharedLock(holder);
+        co_return false;
+    }
+
+    co_await LockAwaiter{prev->lock, LockAwaiter::UPGRADE, holder, &scheduler};
+    co_await LockAwaiter{next->lock, LockAwaiter::UPGRADE, holder, &scheduler};
+
+    Attach(prev, next, key, data);
+
+    prev->lock.ReleaseExclusiveLock();
+    next->lock.ReleaseExclusiveLock();
+    co_return true;
+}
+
+AsyncTask<bool> List::DeleteAsync(const int key,
+                                  AsyncScheduler scheduler/* = nullptr*/) {
+    const char token(0);
+    const void* const holder(&token);
+
+    NodePtr prev(head);
+    co_await LockAwaiter{prev->lock,
+                         LockAwaiter::MAY_WRITE,
+                         holder,
+                         &scheduler};
+    const NodePtr del(co_await FindKeyAsync(prev, key, holder, scheduler));
+
+    if(del->key != key || del->kind == Node::TAIL) {
+        prev->lock.ReleaseSharedLock(holder);
+        del->lock.ReleaseSharedLock(holder);
+        co_return false;
+    }
+
+    co_await LockAwaiter{prev->lock, LockAwaiter::UPGRADE, holder, &scheduler};
+    co_await LockAwaiter{del->lock, LockAwaiter::UPGRADE, holder, &scheduler};
+    const NodePtr next(del->nextPtr);
+    co_await LockAwaiter{next->lock, LockAwaiter::WRITE, holder, &scheduler};
+
+    Detach(prev, del, next);
+
+    prev->lock.ReleaseExclusiveLock();
+    del->lock.ReleaseExclusiveLock();
+    next->lock.ReleaseExclusiveLock();
+    co_return true;
+}
+
+AsyncTask<bool> List::SearchAsync(
+                            const int key,
+                            char* data,
+                            AsyncScheduler scheduler/* = nullptr*/) const {
+    const char token(0);
+    const void* const holder(&token);
+
+    NodePtr node(head);
+    co_await LockAwaiter{node->lock, LockAwaiter::READ, holder, &scheduler};
+
+    // A reader may reach a relocated node, as in FindKey, and passes it to
+    // its copy.
+    while(((node->key < key || !node->isNodeActive) && \
+           node->kind != Node::TAIL) || \
+          node->kind == Node::HEAD) {
+        const NodePtr next(node->nextPtr);
+        node->lock.ReleaseSharedLock(holder);
+        node = next;
+        co_await LockAwaiter{node->lock, LockAwaiter::READ, holder, &scheduler};
+    }
+
+    const bool result(node->key == key && node->isNodeActive && \
+                      node->kind != Node::TAIL);
+    if(result) {
+        *data = node->data;
+    }
+    node->lock.ReleaseSharedLock(holder);
+
+    co_return result;
+}
+
+#pragma GCC diagnostic pop
+
+#endif /* LIST_HAS_COROUTINES */
+
 /**=============================================================================
  * End of file
  * ===========================================================================*/
\ No newline at end of file
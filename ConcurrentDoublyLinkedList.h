@@ -24,6 +24,22 @@
  * ===========================================================================*/
 
 #include "ReadMayWriteWriteLock.h"
+#include "StripedCounter.h"
+#include "KeyRankIndex.h"
+#include "ListOptions.h"
+#include "AsyncTask.h"
+#include "NodeArena.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+using std::atomic;
+using std::function;
+using std::string;
+using std::vector;
+using std::unique_ptr;
+using std::chrono::steady_clock;
 
 /**=============================================================================
  * Declarations:
@@ -36,29 +52,78 @@
  */
 class ConcurrentDoublyLinkedList {
 
+    friend class ShardedConcurrentList;
+    friend class FlatCombiningList;
+    friend class DelegatedList;
+
 /**-----------------------------------------------------------------------------
  * Private Definitions:
  * ---------------------------------------------------------------------------*/
 
+    /**
+     * @brief The alignment of a node's lock, and thus of the node.
+     *        If LIST_CACHE_ALIGNED_NODES is defined, the lock starts a new
+     *        cache line, so acquisitions do not invalidate the line of the
+     *        key and the links, and adjacent nodes do not share lines.
+     *        Otherwise, nodes are packed, and take less memory.
+     */
+#ifdef LIST_CACHE_ALIGNED_NODES
+    static constexpr size_t NODE_LOCK_ALIGNMENT = CACHE_LINE_SIZE;
+#else
+    static constexpr size_t NODE_LOCK_ALIGNMENT =
+                                            alignof(Read_MayWrite_Write_Lock);
+#endif
+
     /**
      * @brief The concurrent doubly-linked list's node struct.
      */
     struct Node {
+
+    /**-------------------------------------------------------------------------
+     * Public Definitions:
+     * -----------------------------------------------------------------------*/
+
+        /**
+         * @brief Enumeration type for the different kinds of nodes.
+         */
+        enum Kind : unsigned char {HEAD, ENTRY, TAIL};
     
     /**-------------------------------------------------------------------------
      * Public Internal Variables:
      * -----------------------------------------------------------------------*/
-        
+
+        // The fields up to the data are read by every traversal, and are
+        // rarely modified. They fit in a single cache line.
+
         /**
-         * @brief The key of the node.
+         * @brief The kind of the node: one of the two sentinels of a list, or
+         *        an entry that holds a key-value pair.
+         * 
+         * @remark Nodes may move between lists (see SplitInto and AppendFrom),
+         *         so a thread that started advancing in one list may end up in
+         *         another one. Checking the kind, rather than comparing to the
+         *         list's own head and tail, detects the sentinels of any list.
+         *         As it is constant, no lock is needed for reading it.
          */
-        const int key;
+        const Kind kind;
 
         /**
-         * @brief The data of the node.
+         * @brief Due to concurrency, a thread can hold a pointer to a node
+         *        which was removed from the list. This flag tells the state of
+         *        the node. A node that was relocated (see Compact) is removed
+         *        as well, but its next pointer leads to its copy, so readers
+         *        pass it instead of stopping at it.
          */
-        const char data;
-        
+        bool isNodeActive;
+
+        /**
+         * @brief The key of the node.
+         *        For the head, it is the lowest key that the list accepts, and
+         *        for the tail, it is the highest one. These are modified only
+         *        while holding the sentinel's lock in a write mode.
+         */
+        int key;
+
         /**
          * @brief A pointer to the previous node in the list.
          */
@@ -68,18 +133,30 @@ class ConcurrentDoublyLinkedList {
          * @brief A pointer to the next node in the list.
          */
         shared_ptr<Node> nextPtr;
-        
+
         /**
-         * @brief Due to concurrency, a thread can hold a pointer to a node
-         *        which was removed from the list. This flag tells the state of
-         *        the node.
+         * @brief The list that accounts for the node, in its size counter and
+         *        rank index. It is read and modified only while holding the
+         *        node's lock in a may-write or a write mode.
          */
-        bool isNodeActive;
-        
+        ConcurrentDoublyLinkedList* owner;
+
+        /**
+         * @brief The data of the node.
+         *        It may be replaced in place while holding the node's lock in a
+         *        write mode, or modified by an atomic read-modify-write
+         *        instruction while holding it in any mode. As it is modified
+         *        often, it is kept next to the lock.
+         */
+        atomic<char> data;
+
         /**
          * @brief A personal Read/May-Write/Write lock for the node.
+         *        It is written by every acquisition, so it starts a new cache
+         *        line when nodes are cache-aligned (see NODE_LOCK_ALIGNMENT),
+         *        away from the fields that traversals read.
          */
-        Read_MayWrite_Write_Lock lock;
+        alignas(NODE_LOCK_ALIGNMENT) Read_MayWrite_Write_Lock lock;
         
     /**-------------------------------------------------------------------------
      * Public Methods:
@@ -90,21 +167,122 @@ class ConcurrentDoublyLinkedList {
          * 
          * @param in_key     New node's key.
          * @param in_data    New node's data.
+         * @param in_owner   The list that accounts for the node.
          * @param in_prevPtr A pointer to the previous node.
          * @param in_nextPtr A pointer to the next node.
+         * @param in_kind    New node's kind.
          */
         Node(const int in_key,
              const char in_data,
+             ConcurrentDoublyLinkedList* const in_owner,
              const shared_ptr<Node>& in_prevPtr = nullptr,
-             const shared_ptr<Node>& in_nextPtr = nullptr);
+             const shared_ptr<Node>& in_nextPtr = nullptr,
+             const Kind in_kind = ENTRY);
     };
 
     typedef shared_ptr<Node> NodePtr;
 
+    /**
+     * @brief A single operation of a batch (see ApplySortedBatch).
+     */
+    struct BatchRequest {
+
+        /**
+         * @brief Enumeration type for the different operations of a batch.
+         */
+        enum Type : unsigned char {INSERT, DELETE, SEARCH};
+
+        /**
+         * @brief The operation.
+         */
+        Type type;
+
+        /**
+         * @brief The key of the operation.
+         */
+        int key;
+
+        /**
+         * @brief The data to insert, or the data that was found.
+         */
+        char data;
+
+        /**
+         * @brief The result of the operation, as returned by InsertHead,
+         *        Delete or Search.
+         */
+        bool result;
+    };
+
+#ifdef LIST_HAS_COROUTINES
+
+    /**
+     * @brief Acquires a node lock for a coroutine. If the lock is contended,
+     *        the coroutine is suspended and enqueued in the lock's waiters
+     *        queue, instead of blocking its thread, and it is resumed (by the
+     *        scheduler, or else by the AsyncTrampoline of the thread that runs
+     *        it) when the lock is granted to it, never by the thread that
+     *        released the lock.
+     */
+    struct LockAwaiter {
+
+        /**
+         * @brief Enumeration type for the different lock acquisitions.
+         */
+        enum Mode : unsigned char {READ, MAY_WRITE, WRITE, UPGRADE};
+
+        /**
+         * @brief The lock to acquire.
+         */
+        Read_MayWrite_Write_Lock& lock;
+
+        /**
+         * @brief The acquisition.
+         */
+        Mode mode;
+
+        /**
+         * @brief The identifier of the operation, as the may-writer of the
+         *        lock (see Read_MayWrite_Write_Lock::LockMayWriteOrEnqueue).
+         */
+        const void* holder;
+
+        /**
+         * @brief The scheduler that resumes the coroutine. It must outlive the
+         *        suspension (it is kept in the coroutine's frame).
+         */
+        const AsyncScheduler* scheduler;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        /**
+         * @brief Acquires the lock, or enqueues the coroutine.
+         * 
+         * @param handle The coroutine.
+         * 
+         * @retval true  If the coroutine was suspended.
+         * @retval false If the lock was acquired, so the coroutine goes on.
+         */
+        bool await_suspend(const coroutine_handle<> handle);
+
+        void await_resume() const noexcept {
+        }
+    };
+
+#endif /* LIST_HAS_COROUTINES */
+
 /**-----------------------------------------------------------------------------
  * Private Internal Variables:
  * ---------------------------------------------------------------------------*/
 
+    /**
+     * @brief The configuration the list was created with. Lists made by SplitAt
+     *        get the same configuration.
+     */
+    const ListOptions options;
+
     /**
      * @brief This node acts as the head of the list.
      *        - Its next node is the one with the lowest key value.
@@ -119,10 +297,72 @@ class ConcurrentDoublyLinkedList {
      */
     const NodePtr tail;
 
+    /**
+     * @brief Counts the nodes in the list (not including the head and the
+     *        tail). Updated by every successful insertion and deletion, after
+     *        the list was modified and before the locks are released.
+     */
+    StripedCounter sizeCounter;
+
+    /**
+     * @brief An optional order-statistics index of the keys in the list (see
+     *        ListOptions::isRankIndexed). Updated together with sizeCounter.
+     *        If nullptr, rank and select queries walk the list.
+     */
+    const unique_ptr<KeyRankIndex> rankIndex;
+
+    /**
+     * @brief The node arenas of the NUMA nodes, indexed by NUMA node, if the
+     *        list has a NUMA policy (see ListOptions::numaPolicy), or a single
+     *        arena if it is only huge-paged (see ListOptions::isHugePaged).
+     *        Otherwise, it is empty, and nodes are allocated from the heap.
+     */
+    vector<unique_ptr<NodeArena>> nodeArenas;
+
 /**-----------------------------------------------------------------------------
  * Private Service Methods:
  * ---------------------------------------------------------------------------*/
 
+    /**
+     * @brief Allocates a node of the list, on the NUMA node that the list's
+     *        NUMA policy chooses for its key.
+     * 
+     * @param key  The key of the node.
+     * @param data The data of the node.
+     * @param prev A pointer to the previous node.
+     * @param next A pointer to the next node.
+     * 
+     * @retval NodePtr The node.
+     */
+    NodePtr NewNode(const int key,
+                    const char data,
+                    const NodePtr& prev,
+                    const NodePtr& next);
+
+    /**
+     * @brief Returns the NUMA node that the list's NUMA policy chooses for a
+     *        key.
+     * 
+     * @param key The key.
+     * 
+     * @retval size_t The NUMA node, which is an index of nodeArenas, or 0 if
+     *                the list has no NUMA policy.
+     */
+    size_t NumaNodeFor(const int key) const noexcept;
+
+    /**
+     * @brief Prefetches the lines of a node that its lock acquisition touches,
+     *        if the list's traversal policy is PREFETCHING (see
+     *        ListOptions::TraversalPolicy).
+     * 
+     * @attention The node pointer must have been read while holding a lock, but
+     *            the node itself is not dereferenced.
+     * 
+     * @param node The node that is locked next, or nullptr (past the head or
+     *             the tail), which is ignored.
+     */
+    void Prefetch(const Node* const node) const noexcept;
+
     /**
      * @brief Advancing towards the tail one place, acquiring and releasing
      *        appropriate locks in the process. Returning the updated nodes as
@@ -187,40 +427,353 @@ class ConcurrentDoublyLinkedList {
     NodePtr FindKey(NodePtr& position,
                     const int key,
                     const bool isRead = false) const noexcept;
+
+    /**
+     * @brief Like FindKey, but gives up when a lock can not be acquired before
+     *        the deadline.
+     * 
+     * @attention It is assumed as in FindKey. If the method gives up, no lock
+     *            is held when it exits (including the lock of the position).
+     * 
+     * @param position An input/output parameter. See FindKey.
+     * @param key      The key which is looked for in the list.
+     * @param isRead   See FindKey.
+     * @param deadline The time to give up at.
+     * 
+     * @retval NodePtr See FindKey, or nullptr if the method gave up.
+     */
+    NodePtr TryFindKey(NodePtr& position,
+                       const int key,
+                       const bool isRead,
+                       const steady_clock::time_point deadline) const noexcept;
+
+    /**
+     * @brief Returns the time left until a deadline.
+     * 
+     * @param deadline The deadline.
+     * 
+     * @retval nanoseconds The time left, or zero if the deadline has passed.
+     */
+    static nanoseconds TimeLeft(
+                            const steady_clock::time_point deadline) noexcept;
     
     /**
      * @brief Inserts the key, with the appropriate data, into the ordered
      *        doubly-linked list. The search for the appropriate location in the
      *        list starts from the given position, and the advancement is
      *        towards the list's tail. If the key already exists in the list, no
-     *        insertion is done.
+     *        insertion is done, but the data of the existing node may be
+     *        replaced (see shouldUpdate).
      * 
      * @attention It is assumed that the thread executing this method holds the
      *            lock of the position node in a May-Write mode.
      * @attention It is assumed that the position node is active.
      * @attention It is assumed that the position node is not the tail.
      * 
-     * @param key      New node's key.
-     * @param data     New node's data.
-     * @param position The position from which the operation starts.
+     * @param key          New node's key.
+     * @param data         New node's data.
+     * @param position     The position from which the operation starts.
+     * @param shouldUpdate If true and the key already exists in the list, its
+     *                     data is replaced in place (no relinking is done).
      * 
      * @retval true  If the key and value were inserted to the list.
      * @retval false If the key was already existing in the list.
      */
     bool InsertFromPosition(const NodePtr& position,
                             const int key,
-                            const char data);
+                            const char data,
+                            const bool shouldUpdate = false);
+
+    /**
+     * @brief Checks whether a key is out of the key range of the list, given
+     *        the nodes between which it should be inserted.
+     * 
+     * @param prev The last node whose key is lower than the key.
+     * @param next The node after prev.
+     * @param key  The key to check.
+     * 
+     * @retval true  If the key is out of the list's range.
+     * @retval false If the key is in the list's range.
+     */
+    static bool IsOutOfRange(const NodePtr& prev,
+                             const NodePtr& next,
+                             const int key) noexcept;
+
+    /**
+     * @brief Inserts a new node between two adjacent nodes. Both locks are
+     *        released when the method exits.
+     * 
+     * @attention It is assumed that the thread executing this method holds the
+     *            locks of both nodes in a may-write mode.
+     * 
+     * @param prev The node previous to the new node.
+     * @param next The node next to the new node.
+     * @param key  New node's key.
+     * @param data New node's data.
+     */
+    void Link(const NodePtr& prev,
+              const NodePtr& next,
+              const int key,
+              const char data);
+
+    /**
+     * @brief Links a new node between two adjacent nodes, and accounts for it
+     *        in the list that accounts for prev. The node and its rank index
+     *        entry are allocated before anything is linked, so if either
+     *        allocation throws, the list and its index are left unchanged.
+     * 
+     * @attention It is assumed that the thread executing this method holds the
+     *            locks of both nodes in a write mode.
+     * 
+     * @param prev The node previous to the new node.
+     * @param next The node next to the new node.
+     * @param key  New node's key.
+     * @param data New node's data.
+     */
+    static void Attach(const NodePtr& prev,
+                       const NodePtr& next,
+                       const int key,
+                       const char data);
+
+    /**
+     * @brief Looks for the node with the given key, starting from the head of
+     *        the list, advancing in a may-write mode. If the node is found, its
+     *        lock is kept in a may-write mode, so no other thread can modify
+     *        or delete it, while readers may still read it.
+     * 
+     * @attention If a node is returned, its lock is acquired in a may-write
+     *            mode when the method exits. Make sure to release it (or
+     *            upgrade it and release it afterwards).
+     * 
+     * @param key The key of the node to look for.
+     * 
+     * @retval NodePtr A pointer to the node with the key, or nullptr if the key
+     *                 does not exist in the list (no lock is held in this
+     *                 case).
+     */
+    NodePtr FindForModification(const int key) noexcept;
+
+    /**
+     * @brief Looks for the node with the given key, starting from the head of
+     *        the list, advancing in a read mode. If the node is found, its lock
+     *        is kept in a read mode, so it can not be deleted or replaced,
+     *        while its data may still be changed atomically.
+     * 
+     * @attention If a node is returned, its lock is acquired in a read mode
+     *            when the method exits. Make sure to release it.
+     * 
+     * @param key The key of the node to look for.
+     * 
+     * @retval NodePtr A pointer to the node with the key, or nullptr if the key
+     *                 does not exist in the list (no lock is held in this
+     *                 case).
+     */
+    NodePtr FindForRead(const int key) const noexcept;
+
+    /**
+     * @brief Removes a node from the list, given its previous node. The lock
+     *        of the next node is acquired in the process, and all of the locks
+     *        are released when the method exits.
+     * 
+     * @attention It is assumed that the thread executing this method holds the
+     *            locks of both nodes in a may-write mode.
+     * @attention It is assumed that prev->nextPtr is del, and that del is not
+     *            the tail.
+     * 
+     * @param prev The node previous to the removed node.
+     * @param del  The node to remove.
+     */
+    void Unlink(const NodePtr& prev, const NodePtr& del) noexcept;
+
+    /**
+     * @brief Removes a node from between two nodes, and stops accounting for
+     *        it.
+     * 
+     * @attention It is assumed that the thread executing this method holds the
+     *            locks of the three nodes in a write mode.
+     * 
+     * @param prev The node previous to the removed node.
+     * @param del  The node to remove.
+     * @param next The node next to the removed node.
+     */
+    static void Detach(const NodePtr& prev,
+                       const NodePtr& del,
+                       const NodePtr& next) noexcept;
+
+#ifdef LIST_HAS_COROUTINES
+
+    /**
+     * @brief The asynchronous form of FindKey, in a may-write mode. Contended
+     *        locks suspend the coroutine (see LockAwaiter).
+     * 
+     * @attention It is assumed that the operation holds the lock of the
+     *            position in a may-write mode, as the given holder. The locks
+     *            of the output position and candidate nodes are held the same
+     *            way when the coroutine returns. Make sure to release them.
+     * @attention It is assumed that the position node is active, and is not
+     *            the tail.
+     * 
+     * @param position  An input/output parameter. See FindKey.
+     * @param key       The key which is looked for in the list.
+     * @param holder    The identifier of the operation.
+     * @param scheduler The scheduler that resumes the coroutine.
+     * 
+     * @retval NodePtr See FindKey.
+     */
+    static AsyncTask<NodePtr> FindKeyAsync(NodePtr& position,
+                                           const int key,
+                                           const void* const holder,
+                                           const AsyncScheduler& scheduler);
+
+#endif /* LIST_HAS_COROUTINES */
+
+    /**
+     * @brief Applies a batch of insertions (as InsertHead), deletions and
+     *        searches in a single sweep from the head of the list, instead of
+     *        walking from the head once per operation. Operations on the same
+     *        key are applied in their order in the batch.
+     *        The sweep holds the lock of its position in a may-write mode.
+     *        After a node was inserted or deleted there, the position is
+     *        locked again, and the sweep restarts from the head only if the
+     *        position was deleted in the meantime.
+     * 
+     * @attention It is assumed that the requests are sorted by their keys.
+     * 
+     * @param requests The requests. Their results are written into them.
+     * @param count    The number of requests.
+     */
+    void ApplySortedBatch(BatchRequest* const* requests, const size_t count);
+
+    /**
+     * @brief Applies a batch like ApplySortedBatch, but takes no node locks,
+     *        for a list that is touched by a single thread.
+     * 
+     * @attention It is assumed that the requests are sorted by their keys, and
+     *            that no other thread accesses the list's nodes (Size and
+     *            ApproximateSize may run concurrently).
+     * 
+     * @param requests The requests. Their results are written into them.
+     * @param count    The number of requests.
+     */
+    void ApplySortedBatchExclusively(BatchRequest* const* requests,
+                                     const size_t count);
+
+    /**
+     * @brief Chooses how far from the edge of the list a pop operation should
+     *        remove a node, uniformly in [0, width), using a thread-local
+     *        generator.
+     * 
+     * @param width The number of edge nodes to choose from.
+     * 
+     * @retval unsigned int The offset from the edge of the list.
+     */
+    static unsigned int RandomSprayOffset(const unsigned int width) noexcept;
+
+    /**
+     * @brief Locks the last node of the list and the tail, in a may-write
+     *        mode. The last node is found backwards from the tail, and is then
+     *        locked and validated, retrying on a concurrent change.
+     * 
+     * @attention The locks of both returned nodes are acquired when the method
+     *            exits, except for the held node, whose lock is not acquired
+     *            again. Make sure to release them.
+     * 
+     * @param held A node whose lock is already held by the calling thread in a
+     *             may-write mode, or nullptr.
+     * 
+     * @retval NodePtr The last node of the list (the head if it is empty).
+     */
+    NodePtr LockLastAndTail(const NodePtr& held) noexcept;
+
+    /**
+     * @brief Moves the accounting (size counter and rank index) of the nodes
+     *        from the given node up to the next tail, to a new owner. This is
+     *        done node by node, in a may-write mode, so it excludes any
+     *        concurrent insertion or deletion at the moved nodes.
+     * 
+     * @attention It is assumed that the thread executing this method holds the
+     *            lock of the node in a write mode. All of the locks are
+     *            released when the method exits.
+     * 
+     * @param node     The first node to move.
+     * @param newOwner The list that should account for the nodes.
+     */
+    static void MoveOwnership(NodePtr node,
+                              ConcurrentDoublyLinkedList& newOwner) noexcept;
+
+    /**
+     * @brief Moves all the keys that are larger or equal to the given key into
+     *        another list. The key ranges of the lists are split accordingly.
+     *        Only the boundary nodes are locked: the last node lower than the
+     *        key, the first one larger or equal to it, the last node, and the
+     *        sentinels. The pointer work is O(1); threads that are already
+     *        advancing in the moved range go on in the other list. Then, the
+     *        accounting of the moved nodes is moved, node by node.
+     * 
+     * @attention It is assumed that the other list is empty, and that no other
+     *            split or append involving any of the lists runs concurrently.
+     * @remark If the key is not above the list's key range, the whole range is
+     *         moved, and this list accepts no keys afterwards. If the key is
+     *         above the range, nothing is moved, and the other list accepts no
+     *         keys.
+     * 
+     * @param key      The lowest key to move.
+     * @param other    The list to move the keys into.
+     * @param onSwitch A function that is called when the keys were moved, while
+     *                 all the boundary nodes are still locked in a write mode.
+     */
+    void SplitInto(const int key,
+                   ConcurrentDoublyLinkedList& other,
+                   const function<void()>& onSwitch);
+
+    /**
+     * @brief Moves all the keys of another list to the end of this one. The key
+     *        range of this list is extended by the one of the other list. Only
+     *        the boundary nodes are locked: the last node of this list and its
+     *        tail, and the head, first node, last node and tail of the other
+     *        list. The pointer work is O(1). Then, the accounting of the moved
+     *        nodes is moved, node by node.
+     * 
+     * @attention It is assumed that no other split or append involving any of
+     *            the lists runs concurrently.
+     * 
+     * @param other        The list whose keys should be moved.
+     * @param shouldRetire If true, the other list accepts no keys afterwards,
+     *                     so threads that still operate on it fail.
+     * @param onSwitch     A function that is called when the keys were moved,
+     *                     while all the boundary nodes are still locked in a
+     *                     write mode.
+     * 
+     * @retval true  If the keys were moved.
+     * @retval false If the lowest key of the other list is not larger than the
+     *               highest key of this list (nothing is done in this case).
+     */
+    bool AppendFrom(ConcurrentDoublyLinkedList& other,
+                    const bool shouldRetire,
+                    const function<void()>& onSwitch);
 
 /**-----------------------------------------------------------------------------
- * Public Methods:
+ * Public Definitions:
  * ---------------------------------------------------------------------------*/
 
 public:
 
+    /**
+     * @brief Enumeration type for the results of operations that may give up
+     *        (see TryInsert and TrySearch).
+     */
+    enum TryResult : unsigned char {SUCCEEDED, FAILED, TIMED_OUT};
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
     /**
      * @brief The list's constructor.
+     * 
+     * @param options The configuration of the list.
      */
-    ConcurrentDoublyLinkedList();
+    explicit ConcurrentDoublyLinkedList(const ListOptions& options = {});
 
     /**
      * @brief The list's destructor.
@@ -267,6 +820,120 @@ public:
      */
     bool Delete(const int key) noexcept;
 
+    /**
+     * @brief Inserts the key, with the appropriate data, into the ordered
+     *        doubly-linked list, or replaces the data of the key if it already
+     *        exists. Both cases are done in a single traversal, starting from
+     *        the head of the list. An existing node is updated in place, under
+     *        its write lock, without being relinked.
+     * 
+     * @param key  The key to insert or update.
+     * @param data The new data of the key.
+     * 
+     * @retval true  If the key and value were inserted to the list.
+     * @retval false If the key was already existing, and its data was replaced.
+     */
+    bool Upsert(const int key, const char data);
+
+    /**
+     * @brief Inserts the key, with the appropriate data, as InsertHead does,
+     *        and then scans the list from the key towards the tail, without
+     *        traversing from the head again. The lock of the node after the
+     *        key is downgraded from a write to a read mode, so the scan goes
+     *        on from the position of the insertion, and the readers waiting
+     *        for that node are let in meanwhile.
+     *        If the key already exists, the scan starts at its node.
+     * 
+     * @attention The visitor is called while a lock of the list is held, so it
+     *            must not operate on the list.
+     * 
+     * @param key     New node's key.
+     * @param data    New node's data.
+     * @param visitor A function that gets the key and the data of each scanned
+     *                node, in an increasing order of the keys, and returns
+     *                whether the scan should go on.
+     * 
+     * @retval true  If the key and value were inserted to the list.
+     * @retval false If the key was already existing in the list (the scan is
+     *               done anyway), or is out of the list's key range (no scan
+     *               is done).
+     */
+    bool InsertAndScan(const int key,
+                       const char data,
+                       const function<bool(const int, const char)>& visitor);
+
+    /**
+     * @brief Replaces the data of an existing key in place, under the node's
+     *        write lock. The search for the key starts from the head of the
+     *        list. If the key does not exist, nothing is inserted.
+     * 
+     * @param key  The key of the node that should be updated.
+     * @param data The new data of the key.
+     * 
+     * @retval true  If the data of the key was replaced.
+     * @retval false If the key does not existing in the list.
+     */
+    bool Update(const int key, const char data) noexcept;
+
+    /**
+     * @brief Replaces the data of an existing key in place, only if its current
+     *        data equals the expected one. The node is held in a read mode, and
+     *        the data is replaced by an atomic compare-and-swap instruction, so
+     *        concurrent read-modify-write operations on the same key do not
+     *        serialize on the node's lock.
+     * 
+     * @param key      The key of the node that should be updated.
+     * @param expected The data that the key is expected to hold.
+     * @param desired  The new data of the key.
+     * 
+     * @retval true  If the data of the key was replaced.
+     * @retval false If the key does not existing in the list, or its data does
+     *               not equal the expected one.
+     */
+    bool CompareAndSwapValue(const int key,
+                             const char expected,
+                             const char desired) noexcept;
+
+    /**
+     * @brief Atomically adds a delta to the data of an existing key. The node
+     *        is held in a read mode, and the addition is done by an atomic
+     *        instruction, so concurrent additions to the same key do not
+     *        serialize on the node's lock.
+     * 
+     * @param key      The key of the node that should be updated.
+     * @param delta    The value to add to the data (wraps around on overflow).
+     * @param previous An optional output parameter, to which the data before
+     *                 the addition should be written.
+     * 
+     * @retval true  If the delta was added to the data of the key.
+     * @retval false If the key does not existing in the list.
+     */
+    bool FetchAdd(const int key,
+                  const char delta,
+                  char* previous = nullptr) noexcept;
+
+    /**
+     * @brief Atomically replaces the data of an existing key with the result of
+     *        a function applied to it. The node is held in a read mode, and the
+     *        data is replaced by an atomic compare-and-swap loop.
+     * 
+     * @attention The modifier may be invoked more than once, if the data is
+     *            changed concurrently by another thread. It should have no side
+     *            effects, and should not access the list.
+     * 
+     * @param key      The key of the node that should be updated.
+     * @param modifier A function that gets the current data and returns the
+     *                 new data.
+     * @param previous An optional output parameter, to which the data before
+     *                 the replacement should be written.
+     * 
+     * @retval true  If the modifier was applied to the data of the key.
+     * @retval false If the key does not existing in the list.
+     */
+    bool Apply(const int key,
+               const function<char(const char)>& modifier,
+               char* previous = nullptr);
+
     /**
      * @brief Determines whether the key exists in the ordered doubly-linked
      *        list. The search for the appropriate location in the list starts
@@ -281,6 +948,346 @@ public:
      *               parameter is invalid.
      */
     bool Search(const int key, char* data) const noexcept;
+
+    /**
+     * @brief Like InsertHead, but gives up if the node locks on the way can
+     *        not be acquired within the timeout, instead of queuing behind
+     *        a long chain of writers. Threads that give up leave the locks'
+     *        queues, so they do not delay the others.
+     * 
+     * @param key     New node's key.
+     * @param data    New node's data.
+     * @param timeout The longest time to wait for the locks, in total.
+     * 
+     * @retval SUCCEEDED If the key and value were inserted to the list.
+     * @retval FAILED    If the key was already existing in the list, or is out
+     *                   of the list's key range.
+     * @retval TIMED_OUT If the operation gave up. The list was not modified.
+     */
+    TryResult TryInsert(const int key,
+                        const char data,
+                        const nanoseconds timeout);
+
+    /**
+     * @brief Like Search, but gives up if the node locks on the way can not be
+     *        acquired within the timeout. See TryInsert.
+     * 
+     * @param key     The key of the node to look for.
+     * @param data    An output parametr, to which the data should be written.
+     * @param timeout The longest time to wait for the locks, in total.
+     * 
+     * @retval SUCCEEDED If the data was retrieved.
+     * @retval FAILED    If the key does not existing in the list or the output
+     *                   parameter is invalid.
+     * @retval TIMED_OUT If the operation gave up.
+     */
+    TryResult TrySearch(const int key,
+                        char* data,
+                        const nanoseconds timeout) const noexcept;
+
+    /**
+     * @brief Removes the key with the lowest value from the list, and returns
+     *        it with its data. Fit for using the list as a priority queue.
+     * 
+     * @remark When all the consumers pop the very first node, they all upgrade
+     *         the lock of the head. A spray width larger than one relaxes the
+     *         operation: a node is chosen uniformly among the first sprayWidth
+     *         nodes, so concurrent pops mostly upgrade different locks, and
+     *         the head is only passed through.
+     * 
+     * @param key        An output parameter, to which the key should be
+     *                   written.
+     * @param data       An output parameter, to which the data should be
+     *                   written.
+     * @param sprayWidth The number of first nodes from which the removed node
+     *                   is chosen. 1 means a strict minimum.
+     * 
+     * @retval true  If a node was removed.
+     * @retval false If the list is empty or an output parameter is invalid.
+     */
+    bool PopMin(int* key,
+                char* data,
+                const unsigned int sprayWidth = 1) noexcept;
+
+    /**
+     * @brief Removes the key with the highest value from the list, and returns
+     *        it with its data. The candidate node is found backwards from the
+     *        tail, and is then locked and validated in the usual order, so no
+     *        deadlock can occur with operations advancing towards the tail.
+     * 
+     * @remark See PopMin for the meaning of the spray width.
+     * 
+     * @param key        An output parameter, to which the key should be
+     *                   written.
+     * @param data       An output parameter, to which the data should be
+     *                   written.
+     * @param sprayWidth The number of last nodes from which the removed node is
+     *                   chosen. 1 means a strict maximum.
+     * 
+     * @retval true  If a node was removed.
+     * @retval false If the list is empty or an output parameter is invalid.
+     */
+    bool PopMax(int* key,
+                char* data,
+                const unsigned int sprayWidth = 1) noexcept;
+
+    /**
+     * @brief Scans the list from a key towards the tail, holding a single read
+     *        lock at a time, so each entry is visited as it was when the scan
+     *        passed it.
+     * 
+     * @attention The visitor is called while a lock of the list is held, so it
+     *            must not operate on the list.
+     * 
+     * @param key     The lowest key to visit (it does not have to exist in the
+     *                list).
+     * @param visitor A function that gets the key and the data of each scanned
+     *                node, in an increasing order of the keys, and returns
+     *                whether the scan should go on.
+     */
+    void Scan(const int key,
+              const function<bool(const int, const char)>& visitor) const;
+
+    /**
+     * @brief Returns the key with the lowest value in the list, with its data,
+     *        without removing it. The key was the lowest one at some point
+     *        during the call.
+     * 
+     * @param key  An output parameter, to which the key should be written.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the key and data were retrieved.
+     * @retval false If the list is empty or an output parameter is invalid.
+     */
+    bool PeekMin(int* key, char* data) const noexcept;
+
+    /**
+     * @brief Returns the key with the highest value in the list, with its data,
+     *        without removing it. The key was the highest one at some point
+     *        during the call.
+     * 
+     * @param key  An output parameter, to which the key should be written.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the key and data were retrieved.
+     * @retval false If the list is empty or an output parameter is invalid.
+     */
+    bool PeekMax(int* key, char* data) const noexcept;
+
+    /**
+     * @brief Returns the number of keys in the list, without traversing it.
+     *        The result is exact if there are no concurrent insertions and
+     *        deletions. Otherwise, it reflects some of them.
+     * 
+     * @retval size_t The number of keys in the list.
+     */
+    size_t Size() const noexcept;
+
+    /**
+     * @brief Returns an approximation of the number of keys in the list, in
+     *        O(1), by reading a single shared counter. Fit for monitoring,
+     *        where an error of a few thousands keys is negligible.
+     *        The counts of up to 64 threads' stripes, below 64 each, may be
+     *        missing, so the error is at most 4096 keys. Below 4096 keys, the
+     *        stripes are summed as well, and the result is as in Size.
+     * 
+     * @retval size_t The approximate number of keys in the list.
+     */
+    size_t ApproximateSize() const noexcept;
+
+    /**
+     * @brief Returns the number of keys in the list that are lower than the
+     *        given key (which does not have to exist in the list).
+     *        If the list is rank-indexed, this takes O(log(key range)) without
+     *        touching the list. Otherwise, the list is walked from its head in
+     *        a read mode.
+     * 
+     * @param key The key to rank.
+     * 
+     * @retval size_t The number of lower keys.
+     */
+    size_t Rank(const int key) const noexcept;
+
+    /**
+     * @brief Finds the key at a given position in the ordered list, e.g. for
+     *        computing percentiles over the keys.
+     *        If the list is rank-indexed, this takes O(log(key range)) without
+     *        touching the list. Otherwise, the list is walked from its head in
+     *        a read mode.
+     * 
+     * @param index The position of the key, where 0 is the lowest key.
+     * @param key   An output parameter, to which the key should be written.
+     * 
+     * @retval true  If the key was found.
+     * @retval false If there are not enough keys in the list or the output
+     *               parameter is invalid.
+     */
+    bool Select(const size_t index, int* key) const noexcept;
+
+    /**
+     * @brief Moves all the keys that are larger or equal to the given key into
+     *        a new list, without copying any node. Only the nodes at the
+     *        boundary are locked, and the pointer work is O(1), so operations
+     *        on the rest of the list go on meanwhile.
+     *        Afterwards, this list accepts only keys lower than the given key,
+     *        and the new list accepts only keys larger or equal to it, up to
+     *        the highest key this list accepted.
+     * 
+     * @attention It is assumed that no other SplitAt or Splice involving this
+     *            list runs concurrently.
+     * 
+     * @param key The lowest key to move.
+     * 
+     * @retval unique_ptr<ConcurrentDoublyLinkedList> The new list, with the
+     *                                                 configuration of this
+     *                                                 one.
+     */
+    unique_ptr<ConcurrentDoublyLinkedList> SplitAt(const int key);
+
+    /**
+     * @brief Moves all the keys of another list to the end of this one, without
+     *        copying any node. Only the nodes at the boundaries are locked, and
+     *        the pointer work is O(1). This list's key range is extended to
+     *        cover the other one's, and the other list is left empty (and
+     *        usable).
+     * 
+     * @attention It is assumed that no other SplitAt or Splice involving any of
+     *            the lists runs concurrently.
+     * 
+     * @param other The list to move the keys from.
+     * 
+     * @retval true  If the keys were moved.
+     * @retval false If the other list is this list, or its lowest key is not
+     *               larger than the highest key of this list.
+     */
+    bool Splice(ConcurrentDoublyLinkedList& other);
+
+    /**
+     * @brief Relocates all the nodes of the list, in key order, into
+     *        contiguous arena chunks (see NodeArena), so traversals regain
+     *        their spatial locality after long churn. The list is walked like
+     *        a deletion, and each node is replaced by a copy under the write
+     *        locks of the node and its neighbours, so the other operations go
+     *        on meanwhile. Readers that reach a replaced node pass on to its
+     *        copy, and the replaced node is freed when the last of them leaves
+     *        it.
+     * 
+     * @attention It is assumed that no SplitAt or Splice involving this list
+     *            runs concurrently.
+     * 
+     * @retval size_t The number of relocated nodes.
+     */
+    size_t Compact();
+
+    /**
+     * @brief Returns the NUMA node that holds the node of a key, for checking
+     *        the placement (see ListOptions::numaPolicy).
+     * 
+     * @param key The key.
+     * 
+     * @retval int The NUMA node, or -1 if the key does not exist in the list
+     *             or the node is unknown.
+     */
+    int NumaNodeOf(const int key) const noexcept;
+
+    /**
+     * @brief Saves the entries of the list to a binary snapshot file (see
+     *        Snapshot), in key order. The list is walked like a search, with
+     *        read locks only, so the other operations go on meanwhile, and
+     *        each entry is saved as it was when the walk passed it. The file
+     *        is written under a temporary name (path + ".tmp"), and replaces
+     *        the old one only when it is complete and flushed to the disk (see
+     *        Snapshot::Sync).
+     * 
+     * @attention It is assumed that no other snapshot is saved to the same
+     *            path concurrently.
+     * 
+     * @param path The path of the file.
+     * 
+     * @retval true  If the snapshot was saved and flushed.
+     * @retval false If the file could not be written (the old one is kept), or
+     *               its replacement could not be flushed.
+     */
+    bool SaveSnapshot(const string& path) const;
+
+    /**
+     * @brief Loads the entries of a snapshot file (see SaveSnapshot) into an
+     *        empty list. The file is read and checked first, and then the
+     *        nodes are built and linked in a single pass, under the write locks
+     *        of the sentinels, so it takes O(n) instead of the O(n^2) of
+     *        inserting the keys one by one.
+     * 
+     * @param path The path of the file.
+     * 
+     * @retval true  If the entries were loaded.
+     * @retval false If the file could not be read, it is corrupted, the list
+     *               is not empty, or some key is out of the list's key range
+     *               (nothing is loaded in these cases).
+     */
+    bool LoadSnapshot(const string& path);
+
+#ifdef LIST_HAS_COROUTINES
+
+    /**
+     * @brief The asynchronous form of InsertHead (co_await
+     *        list.InsertAsync(key, data)). Where a node lock is contended, the
+     *        coroutine is suspended and enqueued in the lock's waiters queue,
+     *        and its thread is free to run other coroutines. It is resumed
+     *        when the lock is granted to it, so a small thread pool can keep
+     *        many operations in flight. The protocol (and the locks) are the
+     *        same as for the blocking operations, and the two can be mixed.
+     * 
+     * @attention The list must outlive the operation.
+     * @attention Without a scheduler, it is assumed that the operation is run
+     *            by AsyncTask::Get (directly, or by a coroutine that awaits
+     *            it), whose thread resumes it. With a scheduler, the code
+     *            after the co_await runs on the scheduler's thread, so it
+     *            should not block on the list there: the lock it waits for
+     *            may be granted to a coroutine queued behind it.
+     * 
+     * @param key       New node's key.
+     * @param data      New node's data.
+     * @param scheduler Resumes the coroutine when a contended lock is granted
+     *                  to it. If empty, it is resumed by the thread that runs
+     *                  the operation in AsyncTask::Get.
+     * 
+     * @retval true  If the key and value were inserted to the list.
+     * @retval false If the key was already existing in the list, or is out of
+     *               the list's key range.
+     */
+    AsyncTask<bool> InsertAsync(const int key,
+                                const char data,
+                                AsyncScheduler scheduler = nullptr);
+
+    /**
+     * @brief The asynchronous form of Delete. See InsertAsync.
+     * 
+     * @param key       The key of the node to delete.
+     * @param scheduler See InsertAsync.
+     * 
+     * @retval true  If the node was found and deleted.
+     * @retval false If the node was not found.
+     */
+    AsyncTask<bool> DeleteAsync(const int key,
+                                AsyncScheduler scheduler = nullptr);
+
+    /**
+     * @brief The asynchronous form of Search. See InsertAsync.
+     * 
+     * @attention The data pointer must stay valid until the operation returns.
+     * 
+     * @param key       The key of the node to look for.
+     * @param data      An output parameter for the data of the node.
+     * @param scheduler See InsertAsync.
+     * 
+     * @retval true  If the node was found.
+     * @retval false If the node was not found.
+     */
+    AsyncTask<bool> SearchAsync(const int key,
+                                char* data,
+                                AsyncScheduler scheduler = nullptr) const;
+
+#endif /* LIST_HAS_COROUTINES */
 };
 
 /**=============================================================================
@@ -0,0 +1,190 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: DelegatedList.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "DelegatedList.h"
+#include <algorithm>
+#include <cassert>
+
+using std::make_unique;
+using std::scoped_lock;
+using std::upper_bound;
+using std::stable_sort;
+using std::atomic_thread_fence;
+using std::memory_order_relaxed;
+using std::memory_order_seq_cst;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+typedef DelegatedList Delegated;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * DelegatedList::Owner:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+Delegated::Owner::Owner(const ListOptions& options) : list(options),
+                                                      ring(RING_CAPACITY),
+                                                      isSleeping(false) {
+}
+
+/*******************************************************************************
+ * DelegatedList:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+future<bool> Delegated::Send(const Request& request, char* data) {
+    // The first lower bound is the lowest int, so the result is never begin().
+    const auto range(upper_bound(lowerBounds.begin(),
+                                 lowerBounds.end(),
+                                 request.key));
+    Owner& owner(*owners[static_cast<size_t>(range - lowerBounds.begin()) - 1]);
+
+    Message message{request, promise<bool>(), data};
+    future<bool> result(message.result.get_future());
+    while(!owner.ring.TryPush(message)) {
+        std::this_thread::yield(); // The owner is behind; let it catch up.
+    }
+
+    // Pairs with the owner setting isSleeping and then checking its ring, so
+    // at least one of us sees the other.
+    atomic_thread_fence(memory_order_seq_cst);
+    if(owner.isSleeping.load(memory_order_relaxed)) {
+        scoped_lock<mutex> lock(owner.sleepMutex);
+        owner.wakeUp.notify_one();
+    }
+
+    return result;
+}
+
+void Delegated::Serve(Owner& owner) {
+    Message messages[BATCH_SIZE];
+    Request* batch[BATCH_SIZE] = {};
+
+    while(true) {
+        size_t count(0);
+        while(count < BATCH_SIZE && owner.ring.TryPop(messages[count])) {
+            batch[count] = &messages[count].request;
+            ++count;
+        }
+
+        if(count == 0) {
+            unique_lock<mutex> lock(owner.sleepMutex);
+            owner.isSleeping.store(true, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            owner.wakeUp.wait(lock, [this, &owner]() {
+                return !owner.ring.IsEmpty() || isStopping.load();
+            });
+            owner.isSleeping.store(false, memory_order_relaxed);
+
+            if(owner.ring.IsEmpty()) return; // Stopping, with nothing to do.
+            continue;
+        }
+
+        // A stable sort keeps operations of the same key in their order.
+        stable_sort(batch, batch + count, [](const Request* a,
+                                             const Request* b) {
+            return a->key < b->key;
+        });
+        owner.list.ApplySortedBatchExclusively(batch, count);
+
+        for(size_t i = 0; i < count; ++i) {
+            Message& message(messages[i]);
+            if(message.data != nullptr && message.request.result) {
+                *message.data = message.request.data;
+            }
+            message.result.set_value(message.request.result);
+        }
+    }
+}
+
+/* public:
+ *********/
+
+Delegated::DelegatedList(const vector<int>& boundaries,
+                         const ListOptions& options/* = {}*/) :
+                                                        isStopping(false) {
+    lowerBounds.reserve(boundaries.size() + 1);
+    lowerBounds.push_back(numeric_limits<int>::min());
+    for(const int boundary : boundaries) {
+        assert(boundary > lowerBounds.back());
+        lowerBounds.push_back(boundary);
+    }
+
+    owners.reserve(lowerBounds.size());
+    for(size_t i = 0; i < lowerBounds.size(); ++i) {
+        ListOptions ownerOptions(options);
+        ownerOptions.lowestKey = lowerBounds[i];
+        ownerOptions.highestKey = i + 1 < lowerBounds.size() ?
+                                      lowerBounds[i + 1] - 1 :
+                                      numeric_limits<int>::max();
+        owners.push_back(make_unique<Owner>(ownerOptions));
+    }
+
+    for(const unique_ptr<Owner>& owner : owners) {
+        owner->server = thread(&Delegated::Serve, this, std::ref(*owner));
+    }
+}
+
+Delegated::~DelegatedList() noexcept {
+    isStopping.store(true);
+    for(const unique_ptr<Owner>& owner : owners) {
+        {
+            scoped_lock<mutex> lock(owner->sleepMutex);
+            owner->wakeUp.notify_one();
+        }
+        owner->server.join();
+    }
+}
+
+future<bool> Delegated::InsertHead(const int key, const char data) {
+    return Send(Request{Request::INSERT, key, data, false}, nullptr);
+}
+
+future<bool> Delegated::Delete(const int key) {
+    return Send(Request{Request::DELETE, key, '0', false}, nullptr);
+}
+
+future<bool> Delegated::Search(const int key, char* data) {
+    return Send(Request{Request::SEARCH, key, '0', false}, data);
+}
+
+size_t Delegated::Size() const noexcept {
+    size_t size(0);
+    for(const unique_ptr<Owner>& owner : owners) {
+        size += owner->list.Size();
+    }
+    return size;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
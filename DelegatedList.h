@@ -0,0 +1,256 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: DelegatedList.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef DELEGATED_LIST_H_
+#define DELEGATED_LIST_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ConcurrentDoublyLinkedList.h"
+#include "MpscRing.h"
+#include <condition_variable>
+#include <future>
+#include <vector>
+
+using std::vector;
+using std::future;
+using std::promise;
+using std::condition_variable;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A map of keys to data, partitioned by key ranges, where each range is
+ *        owned by a dedicated server thread. Clients delegate their operations
+ *        to the owner, instead of operating on shared nodes.
+ * 
+ * Behavior:
+ *  - Every operation is routed by its key to the owner of its range, and sent
+ *    over a lock-free multi-producer single-consumer ring (see MpscRing). Its
+ *    result is returned through a future.
+ *  - An owner drains its ring, and applies the drained operations as a single
+ *    sorted batch on its own list (see
+ *    ConcurrentDoublyLinkedList::ApplySortedBatchExclusively). A list is
+ *    touched by its owner only, so the batch takes no node locks, and the
+ *    data of its nodes stays in the cache of a single core.
+ *  - An owner with no work sleeps on a condition variable, and is woken by
+ *    the next client that sends it an operation.
+ * 
+ * @remark Comparing this mode to ConcurrentDoublyLinkedList measures the cost
+ *         of the node locks together with the cost of contention and data
+ *         movement between cores.
+ */
+class DelegatedList {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    typedef ConcurrentDoublyLinkedList List;
+    typedef List::BatchRequest Request;
+
+    /**
+     * @brief The number of cells of each owner's ring.
+     */
+    static constexpr size_t RING_CAPACITY = 1024;
+
+    /**
+     * @brief The largest number of operations an owner applies in one sweep.
+     */
+    static constexpr size_t BATCH_SIZE = 64;
+
+    /**
+     * @brief An operation sent to an owner.
+     */
+    struct Message {
+
+        /**
+         * @brief The operation, and its result once it was applied.
+         */
+        Request request;
+
+        /**
+         * @brief The promise of the operation's result.
+         */
+        promise<bool> result;
+
+        /**
+         * @brief For searches, where the found data should be written (before
+         *        the result is set). Otherwise, nullptr.
+         */
+        char* data;
+    };
+
+    /**
+     * @brief The owner of a key range.
+     */
+    struct Owner {
+
+        /**
+         * @brief The list of the range's keys, touched by the owner's thread
+         *        only.
+         */
+        List list;
+
+        /**
+         * @brief The operations sent to the owner.
+         */
+        MpscRing<Message> ring;
+
+        /**
+         * @brief Protects the sleep of the owner's thread.
+         */
+        mutex sleepMutex;
+
+        /**
+         * @brief The owner's thread sleeps on it when its ring is empty.
+         */
+        condition_variable wakeUp;
+
+        /**
+         * @brief Whether the owner's thread sleeps, or is about to.
+         */
+        atomic<bool> isSleeping;
+
+        /**
+         * @brief The owner's thread.
+         */
+        thread server;
+
+        /**
+         * @brief Construct a new Owner object, without starting its thread.
+         * 
+         * @param options The configuration of the owner's list.
+         */
+        explicit Owner(const ListOptions& options);
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The lowest key of each range, in increasing order. The first one
+     *        is always the lowest int, so every key has an owner.
+     */
+    vector<int> lowerBounds;
+
+    /**
+     * @brief The owners. The owner at index i owns the keys in the range
+     *        [lowerBounds[i], lowerBounds[i + 1]).
+     */
+    vector<unique_ptr<Owner>> owners;
+
+    /**
+     * @brief Tells the owners' threads to exit, once their rings are empty.
+     */
+    atomic<bool> isStopping;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Sends an operation to the owner of its key.
+     * 
+     * @param request The operation.
+     * @param data    For searches, where the found data should be written.
+     *                Otherwise, nullptr.
+     * 
+     * @retval future<bool> The future result of the operation.
+     */
+    future<bool> Send(const Request& request, char* data);
+
+    /**
+     * @brief The main loop of an owner's thread.
+     * 
+     * @param owner The owner.
+     */
+    void Serve(Owner& owner);
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The delegated list's constructor. Starts a thread per key range.
+     * 
+     * @attention It is assumed that the boundaries are strictly increasing.
+     * 
+     * @param boundaries The keys at which a new range starts. n boundaries
+     *                   make n + 1 ranges (and threads).
+     * @param options    The configuration of every range's list.
+     */
+    explicit DelegatedList(const vector<int>& boundaries,
+                           const ListOptions& options = {});
+
+    /**
+     * @brief The delegated list's destructor. The owners apply all the
+     *        operations that were sent to them, and their threads are joined.
+     * 
+     * @attention It is assumed that no operation is sent concurrently.
+     */
+    ~DelegatedList() noexcept;
+
+    DelegatedList(const DelegatedList&) = delete;
+    DelegatedList& operator=(const DelegatedList&) = delete;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::InsertHead.
+     * 
+     * @retval future<bool> The future result of the insertion.
+     */
+    future<bool> InsertHead(const int key, const char data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Delete.
+     * 
+     * @retval future<bool> The future result of the deletion.
+     */
+    future<bool> Delete(const int key);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Search.
+     * 
+     * @attention The data parameter must stay valid until the future is
+     *            ready. It is written before that, if the key was found.
+     * 
+     * @retval future<bool> The future result of the search.
+     */
+    future<bool> Search(const int key, char* data);
+
+    /**
+     * @brief Returns the number of keys in all the ranges.
+     *        See ConcurrentDoublyLinkedList::Size.
+     * 
+     * @retval size_t The number of keys.
+     */
+    size_t Size() const noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* DELEGATED_LIST_H_ */
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: DurableList.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "DurableList.h"
+#include <fstream>
+
+using std::make_unique;
+using std::ifstream;
+using std::shared_lock;
+using std::scoped_lock;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * DurableList:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+bool DurableList::Apply(const WriteAheadLog::Operation operation,
+                        const int key,
+                        const char data) {
+    switch(operation) {
+        case WriteAheadLog::INSERT_HEAD:
+            return list.InsertHead(key, data);
+        case WriteAheadLog::INSERT_TAIL:
+            return list.InsertTail(key, data);
+        case WriteAheadLog::DELETE:
+            return list.Delete(key);
+        default:
+            return false;
+    }
+}
+
+DurableList::Result DurableList::Logged(
+                                    const WriteAheadLog::Operation operation,
+                                    const int key,
+                                    const char data) {
+    if(log == nullptr) return CLOSED;
+
+    uint64_t sequence(0);
+    {
+        shared_lock<shared_mutex> checkpointLock(checkpointMutex);
+        const size_t stripe(static_cast<unsigned int>(key) % KEY_STRIPES);
+        scoped_lock<mutex> keyLock(keyMutexes[stripe]);
+        if(!log->IsOpen()) return CLOSED;
+        if(!Apply(operation, key, data)) return FAILED;
+        sequence = log->Append(operation, key, data);
+    }
+
+    // The locks are released, so the threads that wait here share flushes.
+    return log->WaitDurable(sequence) ? SUCCEEDED : NOT_DURABLE;
+}
+
+/* public:
+ *********/
+
+DurableList::DurableList(const string& in_snapshotPath,
+                         const string& logPath,
+                         const ListOptions& options/* = {}*/) :
+                                                list(options),
+                                                snapshotPath(in_snapshotPath) {
+    // A snapshot that exists must load, or the operations before it are lost.
+    if(ifstream(snapshotPath).is_open() && !list.LoadSnapshot(snapshotPath)) {
+        return;
+    }
+
+    const auto replay([this](const WriteAheadLog::Record& record) {
+        Apply(record.operation, record.key, record.data);
+    });
+    log = make_unique<WriteAheadLog>(logPath, replay);
+}
+
+bool DurableList::IsOpen() noexcept {
+    return log != nullptr && log->IsOpen();
+}
+
+DurableList::Result DurableList::InsertHead(const int key, const char data) {
+    return Logged(WriteAheadLog::INSERT_HEAD, key, data);
+}
+
+DurableList::Result DurableList::InsertTail(const int key, const char data) {
+    return Logged(WriteAheadLog::INSERT_TAIL, key, data);
+}
+
+DurableList::Result DurableList::Delete(const int key) {
+    return Logged(WriteAheadLog::DELETE, key, 0);
+}
+
+bool DurableList::Search(const int key, char* data) const noexcept {
+    return list.Search(key, data);
+}
+
+size_t DurableList::Size() const noexcept {
+    return list.Size();
+}
+
+bool DurableList::Checkpoint() {
+    if(log == nullptr) return false;
+
+    scoped_lock<shared_mutex> checkpointLock(checkpointMutex);
+    return list.SaveSnapshot(snapshotPath) && log->Truncate();
+}
+
+size_t DurableList::SyncsNumber() noexcept {
+    return log == nullptr ? 0 : log->SyncsNumber();
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,271 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: DurableList.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef DURABLE_LIST_H_
+#define DURABLE_LIST_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ConcurrentDoublyLinkedList.h"
+#include "WriteAheadLog.h"
+#include <shared_mutex>
+
+using std::shared_mutex;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A list whose insertions and deletions survive a crash: a snapshot of
+ *        the list (see ConcurrentDoublyLinkedList::SaveSnapshot), and a
+ *        write-ahead log of the operations since it (see WriteAheadLog).
+ * 
+ * Behavior:
+ *  - A successful InsertHead, InsertTail or Delete is appended to the log, and
+ *    returns once the log has it on the disk. The flushes are shared by the
+ *    threads that wait for them (group commit), so under load they cost far
+ *    less than a flush per operation.
+ *  - The operations on a key are logged in the order they were applied, by a
+ *    striped mutex of the keys. Operations on different keys commute, so
+ *    their order in the log does not matter.
+ *  - The constructor recovers the list: it loads the snapshot, if there is
+ *    one, and replays the log on top of it. Replaying a record that the
+ *    snapshot already has is harmless (an insertion of an existing key, or a
+ *    deletion of a missing one, fails), so a crash in the middle of a
+ *    Checkpoint loses nothing.
+ *  - Checkpoint saves a new snapshot, and empties the log.
+ * 
+ * @attention Reads are not durable: an operation is visible to Search and
+ *            Size as soon as it is applied, before its record is on the disk,
+ *            so a read may see a change that a crash then loses. If the log
+ *            fails, the changes that were applied but not written stay
+ *            visible (see NOT_DURABLE).
+ * 
+ * @remark The log keeps an order that is consistent with the operations on
+ *         each key, so the recovered list is one that existed.
+ */
+class DurableList {
+
+/**-----------------------------------------------------------------------------
+ * Public Definitions:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief Enumeration type for the results of the logged operations.
+     *        - SUCCEEDED: the operation was applied, and it is durable.
+     *        - FAILED: the operation failed on the list, as the list's
+     *          operation does (the key exists, is missing, or is out of
+     *          range), so nothing changed.
+     *        - NOT_DURABLE: the operation was applied, but the log could not
+     *          be written, so a crash may lose it. The list takes no more
+     *          insertions and deletions afterwards.
+     *        - CLOSED: the list is not open (see IsOpen), so nothing changed.
+     */
+    enum Result : unsigned char {SUCCEEDED, FAILED, NOT_DURABLE, CLOSED};
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+private:
+
+    typedef ConcurrentDoublyLinkedList List;
+
+    /**
+     * @brief The number of stripes of the key mutexes (a power of 2).
+     */
+    static constexpr size_t KEY_STRIPES = 64;
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The list.
+     */
+    List list;
+
+    /**
+     * @brief The path of the snapshot file.
+     */
+    const string snapshotPath;
+
+    /**
+     * @brief The log, or nullptr if the snapshot could not be recovered.
+     */
+    unique_ptr<WriteAheadLog> log;
+
+    /**
+     * @brief Held in a shared mode by the logged operations, and in an
+     *        exclusive mode by Checkpoint, so a snapshot holds all the
+     *        operations of the log that it replaces.
+     */
+    shared_mutex checkpointMutex;
+
+    /**
+     * @brief Serialize the operations on the keys of each stripe, with their
+     *        appends to the log.
+     */
+    mutex keyMutexes[KEY_STRIPES];
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief A service method that applies an operation to the list, without
+     *        logging it.
+     * 
+     * @param operation The operation.
+     * @param key       The key of the operation.
+     * @param data      The data of an insertion.
+     * 
+     * @retval true  If the operation succeeded.
+     * @retval false Otherwise.
+     */
+    bool Apply(const WriteAheadLog::Operation operation,
+               const int key,
+               const char data);
+
+    /**
+     * @brief A service method that applies an operation to the list, logs it
+     *        if it succeeded, and waits until it is durable.
+     * 
+     * @param operation The operation.
+     * @param key       The key of the operation.
+     * @param data      The data of an insertion.
+     * 
+     * @retval Result The result of the operation (see Result).
+     */
+    Result Logged(const WriteAheadLog::Operation operation,
+                  const int key,
+                  const char data);
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The list's constructor. Recovers the list from the snapshot and
+     *        the log, and opens the log (files that do not exist are created
+     *        on demand).
+     * 
+     * @param in_snapshotPath The path of the snapshot file.
+     * @param logPath         The path of the log file.
+     * @param options         The configuration of the list.
+     */
+    DurableList(const string& in_snapshotPath,
+                const string& logPath,
+                const ListOptions& options = {});
+
+    DurableList(const DurableList&) = delete;
+    DurableList& operator=(const DurableList&) = delete;
+
+    /**
+     * @brief Checks whether the list was recovered, and takes operations.
+     * 
+     * @retval true  If the list was recovered, and its log can be written.
+     * @retval false If the snapshot exists but is corrupted, or the log could
+     *               not be opened or written (the list takes no insertions and
+     *               deletions).
+     */
+    bool IsOpen() noexcept;
+
+    /**
+     * @brief As ConcurrentDoublyLinkedList::InsertHead, and durable.
+     * 
+     * @param key  New node's key.
+     * @param data New node's data.
+     * 
+     * @retval Result SUCCEEDED if the key and value were inserted, and it is
+     *                durable (see Result).
+     */
+    Result InsertHead(const int key, const char data);
+
+    /**
+     * @brief As ConcurrentDoublyLinkedList::InsertTail, and durable.
+     * 
+     * @param key  New node's key.
+     * @param data New node's data.
+     * 
+     * @retval Result SUCCEEDED if the key and value were inserted, and it is
+     *                durable (see Result).
+     */
+    Result InsertTail(const int key, const char data);
+
+    /**
+     * @brief As ConcurrentDoublyLinkedList::Delete, and durable.
+     * 
+     * @param key The key to delete.
+     * 
+     * @retval Result SUCCEEDED if the key was deleted, and it is durable (see
+     *                Result).
+     */
+    Result Delete(const int key);
+
+    /**
+     * @brief As ConcurrentDoublyLinkedList::Search. It may see a change that
+     *        is not durable yet.
+     * 
+     * @param key  The key to look for.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the key was found.
+     * @retval false Otherwise.
+     */
+    bool Search(const int key, char* data) const noexcept;
+
+    /**
+     * @brief As ConcurrentDoublyLinkedList::Size. It may count changes that
+     *        are not durable yet.
+     * 
+     * @retval size_t The number of entries.
+     */
+    size_t Size() const noexcept;
+
+    /**
+     * @brief Saves a snapshot of the list, and empties the log. Insertions and
+     *        deletions wait meanwhile.
+     * 
+     * @retval true  If the snapshot was saved and the log was emptied.
+     * @retval false Otherwise (if the snapshot could not be saved, the log is
+     *               kept).
+     */
+    bool Checkpoint();
+
+    /**
+     * @brief Returns the number of flushes of the log (see
+     *        WriteAheadLog::SyncsNumber).
+     * 
+     * @retval size_t The number of flushes.
+     */
+    size_t SyncsNumber() noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* DURABLE_LIST_H_ */
\ No newline at end of file
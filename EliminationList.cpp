@@ -0,0 +1,174 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: EliminationList.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "EliminationList.h"
+#include <thread>
+
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_acq_rel;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+typedef EliminationList Eliminating;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * EliminationList:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+uint64_t Eliminating::Pack(const State state,
+                           const Type type,
+                           const int key,
+                           const char data) noexcept {
+    return static_cast<uint64_t>(static_cast<uint32_t>(key)) | \
+           static_cast<uint64_t>(static_cast<unsigned char>(data)) << 32 | \
+           static_cast<uint64_t>(state) << 40 | \
+           static_cast<uint64_t>(type) << 48;
+}
+
+Eliminating::State Eliminating::StateOf(const uint64_t word) noexcept {
+    return static_cast<State>((word >> 40) & 0xFF);
+}
+
+Eliminating::Type Eliminating::TypeOf(const uint64_t word) noexcept {
+    return static_cast<Type>((word >> 48) & 0xFF);
+}
+
+int Eliminating::KeyOf(const uint64_t word) noexcept {
+    return static_cast<int>(static_cast<uint32_t>(word & 0xFFFFFFFF));
+}
+
+char Eliminating::DataOf(const uint64_t word) noexcept {
+    return static_cast<char>((word >> 32) & 0xFF);
+}
+
+bool Eliminating::TryEliminate(const Type type,
+                               const int key,
+                               const char data) noexcept {
+    Slot& slot(slots[static_cast<uint32_t>(key) * 2654435761U % SLOTS_NUMBER]);
+    uint64_t word(slot.word.load(memory_order_acquire));
+
+    // A complementary operation waits for us.
+    if(StateOf(word) == WAITING && KeyOf(word) == key && \
+       TypeOf(word) != type) {
+        const uint64_t matched(Pack(MATCHED,
+                                    TypeOf(word),
+                                    key,
+                                    type == INSERT ? data : DataOf(word)));
+        if(!slot.word.compare_exchange_strong(word,
+                                              matched,
+                                              memory_order_acq_rel)) {
+            return false;
+        }
+        CompleteMatch(slot, type, matched);
+        return true;
+    }
+
+    // Wait for a complementary operation, if the slot is free.
+    const uint64_t offer(Pack(WAITING, type, key, data));
+    if(StateOf(word) != EMPTY || \
+       !slot.word.compare_exchange_strong(word, offer, memory_order_acq_rel)) {
+        return false;
+    }
+    for(unsigned int i = 0; i < WAIT_ROUNDS; ++i) {
+        if(slot.word.load(memory_order_relaxed) != offer) break;
+        std::this_thread::yield();
+    }
+
+    uint64_t expected(offer);
+    if(slot.word.compare_exchange_strong(expected,
+                                         Pack(EMPTY, INSERT, 0, 0),
+                                         memory_order_acq_rel)) {
+        return false; // Withdrawn, with no match.
+    }
+    CompleteMatch(slot, type, expected);
+    return true;
+}
+
+void Eliminating::CompleteMatch(Slot& slot,
+                                const Type type,
+                                const uint64_t matched) noexcept {
+    if(type == DELETE) {
+        const char data(DataOf(matched));
+        list.Apply(KeyOf(matched), [data](const char) noexcept {
+            return data;
+        });
+        slot.word.store(Pack(DONE, TypeOf(matched), KeyOf(matched), data),
+                        memory_order_release);
+        return;
+    }
+
+    while(StateOf(slot.word.load(memory_order_acquire)) != DONE) {
+        std::this_thread::yield();
+    }
+    slot.word.store(Pack(EMPTY, INSERT, 0, 0), memory_order_release);
+}
+
+/* public:
+ *********/
+
+Eliminating::EliminationList(const ListOptions& options/* = {}*/) :
+                                            list(options),
+                                            lowestKey(options.lowestKey),
+                                            highestKey(options.highestKey) {
+    for(Slot& slot : slots) {
+        slot.word.store(Pack(EMPTY, INSERT, 0, 0), memory_order_relaxed);
+    }
+}
+
+bool Eliminating::InsertHead(const int key, const char data) {
+    if(key >= lowestKey && key <= highestKey && \
+       TryEliminate(INSERT, key, data)) {
+        return true;
+    }
+    return list.InsertHead(key, data);
+}
+
+bool Eliminating::Delete(const int key) noexcept {
+    if(key >= lowestKey && key <= highestKey && \
+       TryEliminate(DELETE, key, '0')) {
+        return true;
+    }
+    return list.Delete(key);
+}
+
+bool Eliminating::Search(const int key, char* data) const noexcept {
+    return list.Search(key, data);
+}
+
+size_t Eliminating::Size() const noexcept {
+    return list.Size();
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,238 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: EliminationList.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef ELIMINATION_LIST_H_
+#define ELIMINATION_LIST_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ConcurrentDoublyLinkedList.h"
+#include <cstdint>
+
+using std::uint32_t;
+using std::uint64_t;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A front end of a concurrent doubly-linked list, with an elimination
+ *        array where concurrent InsertHead and Delete operations on the same
+ *        key meet and cancel each other out.
+ * 
+ * Behavior:
+ *  - The slot of a key is chosen by hashing it, so complementary operations
+ *    on the same key look for each other in the same slot.
+ *  - An operation first tries to match a complementary operation that waits
+ *    in its slot. Otherwise, it waits in the slot for a short while, if it is
+ *    free. An operation that was not matched is applied on the list.
+ *  - A matched pair replaces an insertion and a deletion, each with its own
+ *    may-write traversal, write locks, and allocation or unlinking, by a
+ *    single in-place store of the inserted data, under read locks only (see
+ *    ConcurrentDoublyLinkedList::Apply). Both operations return true:
+ *    - If the key exists, the deletion is linearized first, and then the
+ *      insertion, which leaves the key with the inserted data.
+ *    - If the key does not exist, the insertion is linearized first, and then
+ *      the deletion, which leaves the list as it was.
+ *    The store is done by the deleting thread, and the inserting thread
+ *    returns only after it was done, so both operations are linearized while
+ *    they are in progress.
+ * 
+ * @remark A pair can not cancel out without looking at the list at all, since
+ *         only the list tells which of the two orders above took place.
+ */
+class EliminationList {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    typedef ConcurrentDoublyLinkedList List;
+
+    /**
+     * @brief The number of slots of the elimination array.
+     */
+    static constexpr unsigned int SLOTS_NUMBER = 64;
+
+    /**
+     * @brief The number of times a waiting operation yields, before it gives
+     *        up and goes to the list.
+     */
+    static constexpr unsigned int WAIT_ROUNDS = 16;
+
+    /**
+     * @brief Enumeration type for the operations that can be eliminated.
+     */
+    enum Type : unsigned char {INSERT, DELETE};
+
+    /**
+     * @brief Enumeration type for the states of a slot.
+     *        - EMPTY:   No operation uses the slot.
+     *        - WAITING: An operation waits for a complementary one.
+     *        - MATCHED: Two operations met. The deleting one stores the data.
+     *        - DONE:    The data was stored. The inserting operation empties
+     *                   the slot.
+     */
+    enum State : unsigned char {EMPTY, WAITING, MATCHED, DONE};
+
+    /**
+     * @brief A slot of the elimination array, padded to a cache line. Its word
+     *        packs the state, the type of the waiting operation, the key and
+     *        the inserted data, so a slot changes with a single
+     *        compare-and-swap.
+     */
+    struct alignas(CACHE_LINE_SIZE) Slot {
+
+        /**
+         * @brief The packed word.
+         */
+        atomic<uint64_t> word;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The list.
+     */
+    List list;
+
+    /**
+     * @brief The lowest key the list accepts. Operations on keys out of the
+     *        list's range are never eliminated.
+     */
+    const int lowestKey;
+
+    /**
+     * @brief The highest key the list accepts.
+     */
+    const int highestKey;
+
+    /**
+     * @brief The elimination array.
+     */
+    Slot slots[SLOTS_NUMBER];
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Packs the fields of a slot into a word.
+     * 
+     * @param state The state of the slot.
+     * @param type  The type of the waiting operation.
+     * @param key   The key of the operations.
+     * @param data  The inserted data.
+     * 
+     * @retval uint64_t The packed word.
+     */
+    static uint64_t Pack(const State state,
+                         const Type type,
+                         const int key,
+                         const char data) noexcept;
+
+    /**
+     * @brief Extracts the state from a packed word.
+     */
+    static State StateOf(const uint64_t word) noexcept;
+
+    /**
+     * @brief Extracts the type of the waiting operation from a packed word.
+     */
+    static Type TypeOf(const uint64_t word) noexcept;
+
+    /**
+     * @brief Extracts the key from a packed word.
+     */
+    static int KeyOf(const uint64_t word) noexcept;
+
+    /**
+     * @brief Extracts the inserted data from a packed word.
+     */
+    static char DataOf(const uint64_t word) noexcept;
+
+    /**
+     * @brief Tries to eliminate an operation with a complementary one.
+     * 
+     * @param type The type of the operation.
+     * @param key  The key of the operation.
+     * @param data The inserted data (ignored for deletions).
+     * 
+     * @retval true  If the operation was eliminated. It returns true.
+     * @retval false If the operation should be applied on the list.
+     */
+    bool TryEliminate(const Type type, const int key, const char data) noexcept;
+
+    /**
+     * @brief Completes the part of an operation in a matched pair.
+     * 
+     * @param slot    The slot where the pair met.
+     * @param type    The type of the operation.
+     * @param matched The packed word of the matched slot.
+     */
+    void CompleteMatch(Slot& slot,
+                       const Type type,
+                       const uint64_t matched) noexcept;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The elimination list's constructor.
+     * 
+     * @param options The configuration of the list.
+     */
+    explicit EliminationList(const ListOptions& options = {});
+
+    EliminationList(const EliminationList&) = delete;
+    EliminationList& operator=(const EliminationList&) = delete;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::InsertHead.
+     */
+    bool InsertHead(const int key, const char data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Delete.
+     */
+    bool Delete(const int key) noexcept;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Search.
+     */
+    bool Search(const int key, char* data) const noexcept;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Size.
+     */
+    size_t Size() const noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* ELIMINATION_LIST_H_ */
\ No newline at end of file
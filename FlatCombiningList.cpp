@@ -0,0 +1,175 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: FlatCombiningList.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "FlatCombiningList.h"
+#include "ThreadSlot.h"
+#include <algorithm>
+#include <thread>
+
+using std::stable_sort;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::current_exception;
+using std::rethrow_exception;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+typedef FlatCombiningList Combining;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * FlatCombiningList::CombinerRole:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+Combining::CombinerRole::CombinerRole(atomic<bool>& in_isCombining) noexcept :
+                                                isCombining(in_isCombining) {
+}
+
+Combining::CombinerRole::~CombinerRole() {
+    isCombining.store(false, memory_order_release);
+}
+
+/*******************************************************************************
+ * FlatCombiningList:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+void Combining::Execute(Request& request) {
+    PublicationRecord& record(records[ThreadSlot::Index() % RECORDS_NUMBER]);
+
+    PublicationRecord::State expected(PublicationRecord::FREE);
+    if(!record.state.compare_exchange_strong(expected,
+                                             PublicationRecord::CLAIMED,
+                                             memory_order_acquire)) {
+        // The record is used by a thread that shares our slot.
+        Request* const requests[] = {&request};
+        list.ApplySortedBatch(requests, 1);
+        return;
+    }
+
+    record.request = request;
+    record.state.store(PublicationRecord::PENDING, memory_order_release);
+
+    PublicationRecord::State state(PublicationRecord::PENDING);
+    while(state == PublicationRecord::PENDING) {
+        if(!isCombining.load(memory_order_relaxed) && \
+           !isCombining.exchange(true, memory_order_acquire)) {
+            const CombinerRole role(isCombining);
+            Combine();
+        } else {
+            std::this_thread::yield();
+        }
+        state = record.state.load(memory_order_acquire);
+    }
+
+    request = record.request;
+    const exception_ptr exception(std::move(record.exception));
+    record.exception = nullptr;
+    record.state.store(PublicationRecord::FREE, memory_order_release);
+    if(state == PublicationRecord::FAILED) rethrow_exception(exception);
+}
+
+void Combining::Combine() {
+    Request* batch[RECORDS_NUMBER] = {};
+    PublicationRecord* published[RECORDS_NUMBER] = {};
+    size_t count(0);
+
+    for(PublicationRecord& record : records) {
+        if(record.state.load(memory_order_acquire) == \
+           PublicationRecord::PENDING) {
+            published[count] = &record;
+            batch[count++] = &record.request;
+        }
+    }
+
+    PublicationRecord::State result(PublicationRecord::COMPLETED);
+    exception_ptr exception;
+    try {
+        // A stable sort keeps requests of the same key in their collection
+        // order.
+        stable_sort(batch,
+                    batch + count,
+                    [](const Request* a, const Request* b) {
+                        return a->key < b->key;
+                    });
+        list.ApplySortedBatch(batch, count);
+    } catch(...) {
+        result = PublicationRecord::FAILED;
+        exception = current_exception();
+    }
+
+    for(size_t i = 0; i < count; ++i) {
+        published[i]->exception = exception;
+        published[i]->state.store(result, memory_order_release);
+    }
+}
+
+/* public:
+ *********/
+
+Combining::FlatCombiningList(const ListOptions& options/* = {}*/) :
+                                                        list(options),
+                                                        isCombining(false) {
+    for(PublicationRecord& record : records) {
+        record.state.store(PublicationRecord::FREE, memory_order_relaxed);
+    }
+}
+
+bool Combining::InsertHead(const int key, const char data) {
+    Request request{Request::INSERT, key, data, false};
+    Execute(request);
+    return request.result;
+}
+
+bool Combining::Delete(const int key) {
+    Request request{Request::DELETE, key, '0', false};
+    Execute(request);
+    return request.result;
+}
+
+bool Combining::Search(const int key, char* data) {
+    if(data == nullptr) return false;
+
+    Request request{Request::SEARCH, key, '0', false};
+    Execute(request);
+    if(request.result) *data = request.data;
+    return request.result;
+}
+
+size_t Combining::Size() const noexcept {
+    return list.Size();
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
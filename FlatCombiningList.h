@@ -0,0 +1,215 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: FlatCombiningList.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef FLAT_COMBINING_LIST_H_
+#define FLAT_COMBINING_LIST_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ConcurrentDoublyLinkedList.h"
+#include <exception>
+
+using std::exception_ptr;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A flat-combining front end of a concurrent doubly-linked list, for
+ *        workloads where many threads issue short operations near the head.
+ * 
+ * Behavior:
+ *  - A thread publishes its operation in a publication record, chosen by its
+ *    thread slot, and then tries to become the combiner.
+ *  - The combiner collects all the published operations, sorts them by their
+ *    keys, and applies them in a single sweep through the list (see
+ *    ConcurrentDoublyLinkedList::ApplySortedBatch). Other threads wait for
+ *    their results, without touching the list.
+ *  - Thus, under contention, a single chain of lock handoffs from the head
+ *    serves the whole batch, instead of a chain per operation.
+ *  - A thread whose record is taken by another thread (sharing its slot)
+ *    applies its operation directly on the list, which is always safe.
+ *  - If the batch throws (e.g. std::bad_alloc), the exception is rethrown to
+ *    every thread whose operation was in it, and the next thread to wait
+ *    becomes the combiner. Operations of the batch may have been applied.
+ */
+class FlatCombiningList {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    typedef ConcurrentDoublyLinkedList List;
+    typedef List::BatchRequest Request;
+
+    /**
+     * @brief The number of publication records, which is also the largest
+     *        possible batch.
+     */
+    static constexpr unsigned int RECORDS_NUMBER = 128;
+
+    /**
+     * @brief A publication record, padded to a cache line.
+     */
+    struct alignas(CACHE_LINE_SIZE) PublicationRecord {
+
+        /**
+         * @brief Enumeration type for the states of a record.
+         *        - FREE:      No thread uses the record.
+         *        - CLAIMED:   A thread is writing its request.
+         *        - PENDING:   The request waits for a combiner.
+         *        - COMPLETED: The result was written, and waits for the thread.
+         *        - FAILED:    The batch threw, and the exception waits for the
+         *                     thread.
+         */
+        enum State : unsigned char {FREE, CLAIMED, PENDING, COMPLETED, FAILED};
+
+        /**
+         * @brief The state of the record.
+         */
+        atomic<State> state;
+
+        /**
+         * @brief The published request, and its result.
+         */
+        Request request;
+
+        /**
+         * @brief The exception thrown by the batch of a FAILED record.
+         */
+        exception_ptr exception;
+    };
+
+    /**
+     * @brief Holds the combiner role, which the calling thread acquired, and
+     *        releases it when destroyed, even if combining throws.
+     */
+    class CombinerRole {
+
+        /**
+         * @brief The flag of the role.
+         */
+        atomic<bool>& isCombining;
+
+    public:
+
+        /**
+         * @brief Takes over the acquired role.
+         * 
+         * @param in_isCombining The flag of the role, already set by the
+         *                       calling thread.
+         */
+        explicit CombinerRole(atomic<bool>& in_isCombining) noexcept;
+
+        /**
+         * @brief Releases the role.
+         */
+        ~CombinerRole();
+
+        CombinerRole(const CombinerRole&) = delete;
+        CombinerRole& operator=(const CombinerRole&) = delete;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The list.
+     */
+    List list;
+
+    /**
+     * @brief Whether a thread currently acts as the combiner.
+     */
+    alignas(CACHE_LINE_SIZE) atomic<bool> isCombining;
+
+    /**
+     * @brief The publication records.
+     */
+    PublicationRecord records[RECORDS_NUMBER];
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Publishes a request and waits for its result, combining the
+     *        pending requests whenever no other thread does.
+     * 
+     * @attention If the batch of the request throws, the exception is
+     *            rethrown.
+     * 
+     * @param request The request. Its result is written into it.
+     */
+    void Execute(Request& request);
+
+    /**
+     * @brief Applies all the pending requests as a single sorted batch. If the
+     *        batch throws, the requests are FAILED with the exception.
+     * 
+     * @attention It is assumed that the thread executing this method is the
+     *            combiner.
+     */
+    void Combine();
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The flat-combining list's constructor.
+     * 
+     * @param options The configuration of the list.
+     */
+    explicit FlatCombiningList(const ListOptions& options = {});
+
+    FlatCombiningList(const FlatCombiningList&) = delete;
+    FlatCombiningList& operator=(const FlatCombiningList&) = delete;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::InsertHead.
+     */
+    bool InsertHead(const int key, const char data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Delete.
+     */
+    bool Delete(const int key);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Search.
+     */
+    bool Search(const int key, char* data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Size.
+     */
+    size_t Size() const noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* FLAT_COMBINING_LIST_H_ */
\ No newline at end of file
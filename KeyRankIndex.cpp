@@ -0,0 +1,260 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: KeyRankIndex.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "KeyRankIndex.h"
+#include "ThreadSlot.h"
+#include <thread>
+#include <new>
+#include <cassert>
+
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::scoped_lock;
+using std::bad_alloc;
+namespace this_thread = std::this_thread;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * KeyRankIndex::TrieNode:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+KeyRankIndex::TrieNode::TrieNode() noexcept {
+    for(unsigned int digit = 0; digit < RADIX; ++digit) {
+        counts[digit].store(0, memory_order_relaxed);
+        children[digit].store(nullptr, memory_order_relaxed);
+    }
+}
+
+KeyRankIndex::TrieNode::~TrieNode() noexcept {
+    for(atomic<TrieNode*>& child : children) {
+        delete child.load(memory_order_relaxed);
+    }
+}
+
+/*******************************************************************************
+ * KeyRankIndex::TreeReader:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+KeyRankIndex::TreeReader::TreeReader(const KeyRankIndex& index) noexcept :
+        stripe(index.readersStripes
+                   [index.readersEpoch.load() % READERS_COUNTERS_NUMBER]
+                   [ThreadSlot::Index() % READERS_STRIPES_NUMBER]) {
+    // Sequentially consistent, so either ReclaimNodes sees the reader, or the
+    // reader does not see the nodes that ReclaimNodes reclaims.
+    stripe.readersNumber.fetch_add(1);
+}
+
+KeyRankIndex::TreeReader::~TreeReader() {
+    stripe.readersNumber.fetch_sub(1, memory_order_release);
+}
+
+/*******************************************************************************
+ * KeyRankIndex:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+uint32_t KeyRankIndex::ToUnsigned(const int key) noexcept {
+    // Flipping the sign bit maps INT_MIN to 0 and INT_MAX to UINT32_MAX.
+    return static_cast<uint32_t>(key) ^ 0x80000000U;
+}
+
+int KeyRankIndex::FromUnsigned(const uint32_t value) noexcept {
+    return static_cast<int>(value ^ 0x80000000U);
+}
+
+unsigned int KeyRankIndex::Digit(const uint32_t value,
+                                 const unsigned int level) noexcept {
+    return (value >> (32 - DIGIT_BITS * (level + 1))) & (RADIX - 1);
+}
+
+void KeyRankIndex::Prune(TrieNode& node, const unsigned int digit) noexcept {
+    scoped_lock<mutex> lock(pruningMutex);
+    try {
+        prunedNodes.reserve(prunedNodes.size() + 1);
+    } catch(const bad_alloc&) {
+        return; // The subtree is kept, and pruned by a later removal.
+    }
+
+    // Fails if a key was added under the child since it was emptied.
+    long count(0);
+    if(!node.counts[digit].compare_exchange_strong(count, PRUNING)) return;
+
+    TrieNode* const child(node.children[digit].exchange(nullptr));
+    node.counts[digit].fetch_sub(PRUNING);
+    if(child != nullptr) prunedNodes.emplace_back(child);
+    ReclaimNodes();
+}
+
+void KeyRankIndex::Subtract(const uint32_t value,
+                            const unsigned int levels) noexcept {
+    // The highest child that this subtraction emptied, if any.
+    TrieNode* emptiedParent(nullptr);
+    unsigned int emptiedDigit(0);
+
+    TrieNode* node(&root);
+    for(unsigned int level = 0; ; ++level) {
+        const unsigned int digit(Digit(value, level));
+        const long count(node->counts[digit].fetch_sub(1));
+        if(level + 1 == levels) break;
+
+        if(count == 1 && emptiedParent == nullptr) {
+            emptiedParent = node;
+            emptiedDigit = digit;
+        }
+        node = node->children[digit].load();
+        assert(node != nullptr);
+    }
+
+    if(emptiedParent != nullptr) Prune(*emptiedParent, emptiedDigit);
+}
+
+void KeyRankIndex::ReclaimNodes() noexcept {
+    const unsigned int epoch(readersEpoch.load(memory_order_relaxed));
+    for(const ReadersStripe& stripe :
+                readersStripes[(epoch + 1) % READERS_COUNTERS_NUMBER]) {
+        if(stripe.readersNumber.load() != 0) return;
+    }
+
+    const auto retiredNodes(static_cast<ptrdiff_t>(retiredNodesNumber));
+    prunedNodes.erase(prunedNodes.begin(),
+                      prunedNodes.begin() + retiredNodes);
+    retiredNodesNumber = prunedNodes.size();
+    readersEpoch.store(epoch + 1);
+}
+
+/* public:
+ *********/
+
+KeyRankIndex::KeyRankIndex() noexcept : readersEpoch(0),
+                                        retiredNodesNumber(0) {
+    for(ReadersStripe (&counter)[READERS_STRIPES_NUMBER] : readersStripes) {
+        for(ReadersStripe& stripe : counter) {
+            stripe.readersNumber.store(0, memory_order_relaxed);
+        }
+    }
+}
+
+void KeyRankIndex::Add(const int key) {
+    const TreeReader reader(*this);
+    const uint32_t value(ToUnsigned(key));
+
+    TrieNode* node(&root);
+    for(unsigned int level = 0; ; ++level) {
+        const unsigned int digit(Digit(value, level));
+        if(node->counts[digit].fetch_add(1) < 0) {
+            // The child is being pruned. It is gone once the count is fixed.
+            while(node->counts[digit].load() < 0) this_thread::yield();
+        }
+        if(level + 1 == LEVELS) return;
+
+        // Sequentially consistent loads, so a child that was pruned before
+        // the reader was counted is not seen (see TreeReader).
+        TrieNode* child(node->children[digit].load());
+        if(child == nullptr) {
+            TrieNode* newChild(nullptr);
+            try {
+                newChild = new TrieNode();
+            } catch(const bad_alloc&) {
+                Subtract(value, level + 1); // Leaves the index unchanged.
+                throw;
+            }
+            if(node->children[digit].compare_exchange_strong(child,
+                                                             newChild)) {
+                child = newChild;
+            } else {
+                delete newChild; // Another thread installed it first.
+            }
+        }
+        node = child;
+    }
+}
+
+void KeyRankIndex::Remove(const int key) noexcept {
+    const TreeReader reader(*this);
+    Subtract(ToUnsigned(key), LEVELS);
+}
+
+size_t KeyRankIndex::Rank(const int key) const noexcept {
+    const TreeReader reader(*this);
+    const uint32_t value(ToUnsigned(key));
+
+    long rank(0);
+    const TrieNode* node(&root);
+    for(unsigned int level = 0; node != nullptr; ++level) {
+        const unsigned int digit(Digit(value, level));
+        for(unsigned int lower = 0; lower < digit; ++lower) {
+            const long count(node->counts[lower].load(memory_order_relaxed));
+            if(count > 0) rank += count; // Not while it is pruned.
+        }
+        if(level + 1 == LEVELS) break;
+
+        node = node->children[digit].load();
+    }
+
+    // Concurrent updates may be seen partially.
+    return rank > 0 ? static_cast<size_t>(rank) : 0;
+}
+
+bool KeyRankIndex::Select(const size_t index, int* key) const noexcept {
+    if(key == nullptr) return false;
+
+    const TreeReader reader(*this);
+    long remaining(static_cast<long>(index));
+    uint32_t value(0);
+    const TrieNode* node(&root);
+    for(unsigned int level = 0; node != nullptr; ++level) {
+        unsigned int digit(0);
+        for(; digit < RADIX; ++digit) {
+            const long count(node->counts[digit].load(memory_order_relaxed));
+            if(count <= 0) continue; // Empty, or being pruned.
+            if(remaining < count) break;
+            remaining -= count;
+        }
+        if(digit == RADIX) return false;
+
+        value = (value << DIGIT_BITS) | digit;
+        if(level + 1 == LEVELS) {
+            *key = FromUnsigned(value);
+            return true;
+        }
+
+        node = node->children[digit].load();
+    }
+
+    return false; // A concurrent insertion did not install its node yet.
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,335 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: KeyRankIndex.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef KEY_RANK_INDEX_H_
+#define KEY_RANK_INDEX_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ListOptions.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::atomic;
+using std::size_t;
+using std::uint32_t;
+using std::numeric_limits;
+using std::unique_ptr;
+using std::mutex;
+using std::vector;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief An order-statistics index over a set of int keys, answering rank and
+ *        select queries in O(log(key range)) steps.
+ * 
+ * Behavior:
+ *  - The index is a radix tree over the 32 bits of the keys, with 16 children
+ *    per node (8 levels). Every node counts the keys under each of its
+ *    children.
+ *  - Adding or removing a key updates one counter per level with an atomic
+ *    instruction. Missing nodes are installed with a compare-and-swap.
+ *  - A removal that empties a subtree prunes it, so the tree holds at most
+ *    LEVELS - 1 nodes per key (plus the pruned nodes that are not reclaimed
+ *    yet). Prunings are serialized by a mutex, and never wait for other
+ *    threads.
+ *  - Pruned nodes are reclaimed once no thread that may hold a pointer to them
+ *    is left. Every operation counts itself in a striped readers counter of
+ *    the current epoch, as the routing tables of ShardedConcurrentList do.
+ *  - Queries are exact if there are no concurrent updates. Otherwise, they
+ *    reflect some of them.
+ * 
+ * @attention The index does not check that a removed key was added before.
+ *            This is the responsibility of its owner.
+ */
+class KeyRankIndex {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The number of key bits handled by each level of the tree.
+     */
+    static constexpr unsigned int DIGIT_BITS = 4;
+
+    /**
+     * @brief The number of children of each node.
+     */
+    static constexpr unsigned int RADIX = 1U << DIGIT_BITS;
+
+    /**
+     * @brief The number of levels of the tree.
+     */
+    static constexpr unsigned int LEVELS = 32 / DIGIT_BITS;
+
+    /**
+     * @brief Added to the count of a child while it is pruned, so an addition
+     *        that races with the pruning sees a negative count, and waits for
+     *        it to end.
+     */
+    static constexpr long PRUNING = numeric_limits<long>::min() / 2;
+
+    /**
+     * @brief The number of stripes of each readers counter.
+     */
+    static constexpr unsigned int READERS_STRIPES_NUMBER = 64;
+
+    /**
+     * @brief The number of readers counters. A reader is counted in the
+     *        counter of the epoch's parity.
+     */
+    static constexpr unsigned int READERS_COUNTERS_NUMBER = 2;
+
+    /**
+     * @brief A node of the radix tree.
+     */
+    struct TrieNode {
+
+        /**
+         * @brief The number of keys under each child.
+         */
+        atomic<long> counts[RADIX];
+
+        /**
+         * @brief The children. Nodes of the last level have no children.
+         */
+        atomic<TrieNode*> children[RADIX];
+
+        /**
+         * @brief Construct a new, empty TrieNode object.
+         */
+        TrieNode() noexcept;
+
+        /**
+         * @brief Destroys the node and all of its children.
+         */
+        ~TrieNode() noexcept;
+    };
+
+    /**
+     * @brief A single stripe of the readers counter, padded to a cache line.
+     */
+    struct alignas(CACHE_LINE_SIZE) ReadersStripe {
+
+        /**
+         * @brief The number of threads of the stripe that access the tree.
+         */
+        atomic<long> readersNumber;
+    };
+
+    /**
+     * @brief Marks the calling thread as a reader of the tree while it lives,
+     *        so no node it loads is reclaimed before it is destroyed.
+     */
+    class TreeReader {
+
+        /**
+         * @brief The stripe the thread is counted in.
+         */
+        ReadersStripe& stripe;
+
+    public:
+
+        /**
+         * @brief Counts the calling thread as a reader of the index's tree.
+         * 
+         * @param index The index.
+         */
+        explicit TreeReader(const KeyRankIndex& index) noexcept;
+
+        /**
+         * @brief Stops counting the calling thread as a reader.
+         */
+        ~TreeReader();
+
+        TreeReader(const TreeReader&) = delete;
+        TreeReader& operator=(const TreeReader&) = delete;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The root of the tree.
+     */
+    TrieNode root;
+
+    /**
+     * @brief The readers counters, which count the threads that access the
+     *        tree (see TreeReader).
+     */
+    mutable ReadersStripe readersStripes[READERS_COUNTERS_NUMBER]
+                                        [READERS_STRIPES_NUMBER];
+
+    /**
+     * @brief The epoch of the readers, which chooses the counter new readers
+     *        are counted in. It is advanced by ReclaimNodes.
+     */
+    atomic<unsigned int> readersEpoch;
+
+    /**
+     * @brief The pruned subtrees that were not reclaimed yet, in the order
+     *        they were pruned.
+     */
+    vector<unique_ptr<TrieNode>> prunedNodes;
+
+    /**
+     * @brief The number of subtrees at the start of prunedNodes that were
+     *        pruned before readersEpoch was last advanced.
+     */
+    size_t retiredNodesNumber;
+
+    /**
+     * @brief Serializes prunings, and protects prunedNodes and
+     *        retiredNodesNumber.
+     */
+    mutex pruningMutex;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Maps a key to an unsigned value, keeping the order of the keys.
+     * 
+     * @param key The key to map.
+     * 
+     * @retval uint32_t The mapped key.
+     */
+    static uint32_t ToUnsigned(const int key) noexcept;
+
+    /**
+     * @brief Maps an unsigned value back to the key it was mapped from.
+     * 
+     * @param value The mapped key.
+     * 
+     * @retval int The key.
+     */
+    static int FromUnsigned(const uint32_t value) noexcept;
+
+    /**
+     * @brief Returns the digit of a mapped key at a given level.
+     * 
+     * @param value The mapped key.
+     * @param level The level, where 0 is the level of the root.
+     * 
+     * @retval unsigned int The digit, in [0, RADIX).
+     */
+    static unsigned int Digit(const uint32_t value,
+                              const unsigned int level) noexcept;
+
+    /**
+     * @brief Prunes a child, if no key is under it.
+     * 
+     * @attention It is assumed that the calling thread is a TreeReader.
+     * 
+     * @param node  The parent of the child.
+     * @param digit The digit of the child.
+     */
+    void Prune(TrieNode& node, const unsigned int digit) noexcept;
+
+    /**
+     * @brief Subtracts a key from the counts of the highest levels of its
+     *        path, and prunes the highest child it empties.
+     * 
+     * @attention It is assumed that the calling thread is a TreeReader, and
+     *            that the key was added to these counts before.
+     * 
+     * @param value  The mapped key.
+     * @param levels The number of levels, from the root.
+     */
+    void Subtract(const uint32_t value, const unsigned int levels) noexcept;
+
+    /**
+     * @brief Reclaims the subtrees that were pruned before the previous epoch,
+     *        if no reader of that epoch is left, and advances the epoch.
+     * 
+     * @attention It is assumed that pruningMutex is held.
+     */
+    void ReclaimNodes() noexcept;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The index's constructor. The index starts empty.
+     */
+    KeyRankIndex() noexcept;
+
+    KeyRankIndex(const KeyRankIndex&) = delete;
+    KeyRankIndex& operator=(const KeyRankIndex&) = delete;
+
+    /**
+     * @brief Adds a key to the index. If the allocation of a node throws, the
+     *        index is left unchanged.
+     * 
+     * @param key The key to add.
+     */
+    void Add(const int key);
+
+    /**
+     * @brief Removes a key from the index.
+     * 
+     * @attention It is assumed that the key was added before.
+     * 
+     * @param key The key to remove.
+     */
+    void Remove(const int key) noexcept;
+
+    /**
+     * @brief Returns the number of keys in the index that are lower than the
+     *        given key.
+     * 
+     * @param key The key to rank.
+     * 
+     * @retval size_t The number of lower keys.
+     */
+    size_t Rank(const int key) const noexcept;
+
+    /**
+     * @brief Finds the key at a given position in the ordered set of keys.
+     * 
+     * @param index The position of the key, where 0 is the lowest key.
+     * @param key   An output parameter, to which the key should be written.
+     * 
+     * @retval true  If the key was found.
+     * @retval false If there are not enough keys in the index.
+     */
+    bool Select(const size_t index, int* key) const noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* KEY_RANK_INDEX_H_ */
\ No newline at end of file
@@ -0,0 +1,179 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: ListOptions.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef LIST_OPTIONS_H_
+#define LIST_OPTIONS_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+using std::size_t;
+using std::numeric_limits;
+using std::vector;
+
+/**=============================================================================
+ * Definitions:
+ * ===========================================================================*/
+
+/**
+ * @brief The size of a cache line, in bytes, as assumed by every padded or
+ *        aligned structure of the list and its front ends.
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief Per-list configuration of the concurrent doubly-linked list. The
+ *        default values give the plain list, as described in the assignment.
+ */
+struct ListOptions {
+
+    /**
+     * @brief If true, the list maintains an order-statistics index, updated on
+     *        every insertion and deletion, so Rank and Select are answered in
+     *        O(log(key range)) instead of walking the list from its head.
+     */
+    bool isRankIndexed = false;
+
+    /**
+     * @brief The lowest key that the list accepts. Insertions of lower keys
+     *        fail, as if the key already existed.
+     */
+    int lowestKey = numeric_limits<int>::min();
+
+    /**
+     * @brief The highest key that the list accepts. Insertions of higher keys
+     *        fail, as if the key already existed.
+     */
+    int highestKey = numeric_limits<int>::max();
+
+    /**
+     * @brief The most backoff rounds a thread spins for a contended node lock,
+     *        before it waits in the lock's queue and sleeps. Each lock adapts
+     *        its spinning, below this bound, to the number of rounds that
+     *        recent acquisitions needed. If 0, a thread sleeps right away.
+     * 
+     * @remark Spinning pays off when the locks are held for short times and
+     *         there are more cores than busy threads. On a single core, it is
+     *         skipped anyway.
+     */
+    unsigned int maxSpinRounds = 0;
+
+    /**
+     * @brief If true, the node locks are biased towards readers: while no
+     *        writer has come lately, a reader only publishes itself in a
+     *        global table of visible readers, instead of incrementing the
+     *        readers counter of the node, so read-only traversals write no
+     *        shared node memory. A writer revokes the bias, and waits for the
+     *        visible readers of the node to leave.
+     * 
+     * @remark It pays off for read-mostly lists, whose first nodes are read by
+     *         every operation. Writes become more expensive.
+     */
+    bool isReadBiased = false;
+
+    /**
+     * @brief Enumeration type for the ways traversals walk the nodes.
+     *        - PLAIN: each node is loaded when its lock is acquired.
+     *        - PREFETCHING: as soon as a node is locked, the node after it
+     *          (in the direction of the traversal) is prefetched (its key and
+     *          its lock), so its cache miss overlaps a whole hop: the checks
+     *          of the current node and the release of the previous one.
+     */
+    enum TraversalPolicy : unsigned char {PLAIN, PREFETCHING};
+
+    /**
+     * @brief How traversals walk the nodes (see TraversalPolicy).
+     * 
+     * @remark Prefetching pays off for lists that are far larger than the
+     *         cache, where every hop misses, and only where the miss is long
+     *         compared to the lock handoffs of a hop. Otherwise, it only adds
+     *         instructions. The benchmark compares the two policies (see
+     *         RunTraversals in Benchmark/Benchmark.cpp).
+     */
+    TraversalPolicy traversalPolicy = PLAIN;
+
+    /**
+     * @brief Enumeration type for the ways nodes are placed on NUMA nodes (see
+     *        NumaNode).
+     *        - NUMA_DEFAULT: nodes are allocated from the heap, and land on the
+     *          NUMA node of the thread that touches them first.
+     *        - NUMA_LOCAL: nodes are allocated from an arena of the NUMA node
+     *          that the inserting thread runs on.
+     *        - NUMA_BY_KEY: nodes are allocated from an arena of the NUMA node
+     *          that numaRanges assigns to their keys.
+     */
+    enum NumaPolicy : unsigned char {NUMA_DEFAULT, NUMA_LOCAL, NUMA_BY_KEY};
+
+    /**
+     * @brief A range of keys, which is placed on a NUMA node. It spans up to
+     *        the lowest key of the next range.
+     */
+    struct NumaRange {
+
+        /**
+         * @brief The lowest key of the range.
+         */
+        int lowestKey;
+
+        /**
+         * @brief The NUMA node. Nodes that the system does not have are
+         *        replaced by node 0.
+         */
+        int numaNode;
+    };
+
+    /**
+     * @brief How nodes are placed on NUMA nodes (see NumaPolicy).
+     * 
+     * @remark Placing each key range on the NUMA node of the threads that use
+     *         it most keeps their traversals off the interconnect.
+     */
+    NumaPolicy numaPolicy = NUMA_DEFAULT;
+
+    /**
+     * @brief The key ranges of NUMA_BY_KEY, sorted by their lowest keys. Keys
+     *        below the first range are placed as in NUMA_LOCAL.
+     */
+    vector<NumaRange> numaRanges = {};
+
+    /**
+     * @brief True to allocate the nodes from arenas whose chunks are backed by
+     *        2MB huge pages (see NodeArena), with or without a NUMA policy.
+     * 
+     * @remark With millions of nodes, the traversals miss the TLB on nearly
+     *         every hop over regular pages. Huge pages cover the same nodes
+     *         with 512 times fewer entries. Compact packs the nodes into
+     *         huge pages as well.
+     */
+    bool isHugePaged = false;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* LIST_OPTIONS_H_ */
\ No newline at end of file
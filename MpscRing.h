@@ -0,0 +1,210 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: MpscRing.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef MPSC_RING_H_
+#define MPSC_RING_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ListOptions.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+using std::atomic;
+using std::size_t;
+using std::unique_ptr;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A bounded, lock-free, multi-producer single-consumer ring buffer.
+ * 
+ * Behavior:
+ *  - Every cell has a sequence number, which tells whether it is free for the
+ *    producer of a given position, or full for the consumer of it.
+ *  - Producers claim a position with a single compare-and-swap, and publish
+ *    the value with a release store to the cell's sequence number. The
+ *    consumer needs no atomic read-modify-write at all.
+ *  - Each cell is on its own cache line, so producers of adjacent positions
+ *    do not write to the same cache line.
+ * 
+ * @attention Only a single thread may pop values (and call IsEmpty).
+ */
+template<typename T>
+class MpscRing {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief A single cell of the ring, padded to a cache line.
+     */
+    struct alignas(CACHE_LINE_SIZE) Cell {
+
+        /**
+         * @brief Equals the position of the cell when it is free for the
+         *        producer of the position, and the position + 1 when it holds
+         *        the value of the position.
+         */
+        atomic<size_t> sequence;
+
+        /**
+         * @brief The value.
+         */
+        T value;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The number of cells (a power of 2).
+     */
+    const size_t capacity;
+
+    /**
+     * @brief The cells.
+     */
+    const unique_ptr<Cell[]> cells;
+
+    /**
+     * @brief The next position to push into.
+     */
+    alignas(CACHE_LINE_SIZE) atomic<size_t> pushPosition;
+
+    /**
+     * @brief The next position to pop from. Used by the consumer only.
+     */
+    alignas(CACHE_LINE_SIZE) size_t popPosition;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The ring's constructor. The ring starts empty.
+     * 
+     * @attention It is assumed that the capacity is a power of 2.
+     * 
+     * @param in_capacity The maximal number of values in the ring.
+     */
+    explicit MpscRing(const size_t in_capacity);
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * @brief Pushes a value into the ring, if it is not full.
+     * 
+     * @param value The value to push. It is moved from only if it was pushed.
+     * 
+     * @retval true  If the value was pushed.
+     * @retval false If the ring is full.
+     */
+    bool TryPush(T& value);
+
+    /**
+     * @brief Pops the oldest value from the ring, if it is not empty.
+     * 
+     * @param value An output parameter, to which the value is moved.
+     * 
+     * @retval true  If a value was popped.
+     * @retval false If the ring is empty.
+     */
+    bool TryPop(T& value);
+
+    /**
+     * @brief Checks whether the ring is empty, from the consumer's view.
+     * 
+     * @retval true  If there is no value to pop.
+     * @retval false If there is a value to pop.
+     */
+    bool IsEmpty() const noexcept;
+};
+
+/**=============================================================================
+ * Implementation:
+ * ===========================================================================*/
+
+template<typename T>
+MpscRing<T>::MpscRing(const size_t in_capacity) :
+                                        capacity(in_capacity),
+                                        cells(new Cell[in_capacity]),
+                                        pushPosition(0),
+                                        popPosition(0) {
+    for(size_t i = 0; i < capacity; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+bool MpscRing<T>::TryPush(T& value) {
+    size_t position(pushPosition.load(std::memory_order_relaxed));
+    while(true) {
+        Cell& cell(cells[position & (capacity - 1)]);
+        const size_t sequence(cell.sequence.load(std::memory_order_acquire));
+        if(sequence == position) {
+            if(pushPosition.compare_exchange_weak(position,
+                                                  position + 1,
+                                                  std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if(sequence < position) {
+            return false; // The cell still holds the value of the last lap.
+        } else {
+            position = pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename T>
+bool MpscRing<T>::TryPop(T& value) {
+    Cell& cell(cells[popPosition & (capacity - 1)]);
+    if(cell.sequence.load(std::memory_order_acquire) != popPosition + 1) {
+        return false;
+    }
+
+    value = std::move(cell.value);
+    cell.sequence.store(popPosition + capacity, std::memory_order_release);
+    ++popPosition;
+    return true;
+}
+
+template<typename T>
+bool MpscRing<T>::IsEmpty() const noexcept {
+    const Cell& cell(cells[popPosition & (capacity - 1)]);
+    return cell.sequence.load(std::memory_order_acquire) != popPosition + 1;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* MPSC_RING_H_ */
\ No newline at end of file
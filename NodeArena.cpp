@@ -0,0 +1,210 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: NodeArena.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "NodeArena.h"
+#include "NumaNode.h"
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <cassert>
+#ifdef LIST_HAS_HUGE_PAGES
+#include <sys/mman.h>
+#endif
+
+using std::aligned_alloc;
+using std::free;
+using std::uintptr_t;
+using std::bad_alloc;
+using std::scoped_lock;
+using std::memory_order_relaxed;
+using std::memory_order_acq_rel;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * NodeArena:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+NodeArena::Chunk* NodeArena::NewChunk() {
+    if(isHugePaged) {
+        if(region == nullptr || regionUsed == HUGE_PAGE_SIZE / CHUNK_SIZE) {
+            region = NewRegion();
+            regionUsed = 0;
+        }
+
+        // The first chunk was constructed by NewRegion, with its region count.
+        char* const memory(reinterpret_cast<char*>(region) + \
+                           regionUsed * CHUNK_SIZE);
+        Chunk* const chunk(regionUsed == 0 ? region : new(memory) Chunk);
+        ++regionUsed;
+        chunk->liveCount.store(1, memory_order_relaxed);
+        chunk->region = region;
+        return chunk;
+    }
+
+    void* const memory(aligned_alloc(CHUNK_SIZE, CHUNK_SIZE));
+    if(memory == nullptr) throw bad_alloc();
+
+    // Before the header is written, so untouched pages are placed right away.
+    // A failure leaves the default placement.
+    if(numaNode >= 0) NumaNode::Bind(memory, CHUNK_SIZE, numaNode);
+
+    Chunk* const chunk(new(memory) Chunk);
+    chunk->liveCount.store(1, memory_order_relaxed);
+    chunk->region = nullptr;
+    return chunk;
+}
+
+NodeArena::Chunk* NodeArena::NewRegion() const {
+#ifdef LIST_HAS_HUGE_PAGES
+    // Explicit huge pages are aligned to their size, but exist only if the
+    // system has reserved them.
+    void* memory(mmap(nullptr,
+                      HUGE_PAGE_SIZE,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                      -1,
+                      0));
+    if(memory == MAP_FAILED) {
+        // Transparent huge pages back only aligned ranges, so twice the size is
+        // mapped, and the unaligned ends are trimmed.
+        void* const mapping(mmap(nullptr,
+                                 2 * HUGE_PAGE_SIZE,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS,
+                                 -1,
+                                 0));
+        if(mapping == MAP_FAILED) throw bad_alloc();
+
+        char* const begin(static_cast<char*>(mapping));
+        char* const aligned(begin + \
+                            (HUGE_PAGE_SIZE - \
+                             reinterpret_cast<uintptr_t>(begin) % \
+                             HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE);
+        if(aligned > begin) {
+            munmap(begin, static_cast<size_t>(aligned - begin));
+        }
+        munmap(aligned + HUGE_PAGE_SIZE,
+               static_cast<size_t>(begin + HUGE_PAGE_SIZE - aligned));
+
+        // A failure leaves regular pages.
+        madvise(aligned, HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+        memory = aligned;
+    }
+
+    // Before the header is written, as in NewChunk.
+    if(numaNode >= 0) NumaNode::Bind(memory, HUGE_PAGE_SIZE, numaNode);
+
+    Chunk* const first(new(memory) Chunk);
+    first->regionChunks.store(HUGE_PAGE_SIZE / CHUNK_SIZE,
+                              memory_order_relaxed);
+    return first;
+#else
+    // Should not arrive here, as the constructor drops huge pages.
+    assert(false);
+    throw bad_alloc();
+#endif
+}
+
+void NodeArena::Release(Chunk* const chunk) noexcept {
+    if(chunk->liveCount.fetch_sub(1, memory_order_acq_rel) == 1) {
+        if(chunk->region != nullptr) {
+            ReleaseRegion(chunk->region, 1);
+        } else {
+            chunk->~Chunk();
+            free(chunk);
+        }
+    }
+}
+
+void NodeArena::ReleaseRegion(Chunk* const region,
+                              const size_t chunks) noexcept {
+#ifdef LIST_HAS_HUGE_PAGES
+    if(region->regionChunks.fetch_sub(chunks, memory_order_acq_rel) == chunks) {
+        munmap(region, HUGE_PAGE_SIZE);
+    }
+#else
+    static_cast<void>(region);
+    static_cast<void>(chunks);
+#endif
+}
+
+/* public:
+ *********/
+
+NodeArena::NodeArena(const int in_numaNode/* = -1*/,
+                     const bool in_isHugePaged/* = false*/) noexcept :
+                                                    numaNode(in_numaNode),
+#ifdef LIST_HAS_HUGE_PAGES
+                                                    isHugePaged(in_isHugePaged),
+#else
+                                                    isHugePaged(false),
+#endif
+                                                    current(nullptr),
+                                                    used(0),
+                                                    region(nullptr),
+                                                    regionUsed(0) {
+#ifndef LIST_HAS_HUGE_PAGES
+    static_cast<void>(in_isHugePaged);
+#endif
+}
+
+NodeArena::~NodeArena() noexcept {
+    // The chunks that were not carved yet are returned at once.
+    if(region != nullptr && regionUsed < HUGE_PAGE_SIZE / CHUNK_SIZE) {
+        ReleaseRegion(region, HUGE_PAGE_SIZE / CHUNK_SIZE - regionUsed);
+    }
+    if(current != nullptr) Release(current);
+}
+
+void* NodeArena::Allocate(const size_t size, const size_t alignment) {
+    assert((alignment & (alignment - 1)) == 0);
+
+    scoped_lock<mutex> lock(allocationMutex);
+
+    size_t offset((used + alignment - 1) & ~(alignment - 1));
+    if(current == nullptr || offset + size > CHUNK_SIZE) {
+        Chunk* const chunk(NewChunk());
+        if(current != nullptr) Release(current);
+        current = chunk;
+        offset = (sizeof(Chunk) + alignment - 1) & ~(alignment - 1);
+        if(offset + size > CHUNK_SIZE) throw bad_alloc();
+    }
+
+    current->liveCount.fetch_add(1, memory_order_relaxed);
+    used = offset + size;
+    return reinterpret_cast<char*>(current) + offset;
+}
+
+void NodeArena::Deallocate(void* const pointer) noexcept {
+    Release(reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(pointer) & \
+                                     ~(CHUNK_SIZE - 1)));
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
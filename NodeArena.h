@@ -0,0 +1,330 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: NodeArena.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef NODE_ARENA_H_
+#define NODE_ARENA_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @brief Defined if chunks can be backed by huge pages (see
+ *        NodeArena::HUGE_PAGE_SIZE).
+ */
+#if defined(__linux__) && __has_include(<sys/mman.h>)
+#define LIST_HAS_HUGE_PAGES
+#endif
+
+using std::atomic;
+using std::size_t;
+using std::mutex;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief An arena of list nodes, which packs consecutive allocations next to
+ *        each other (see ConcurrentDoublyLinkedList::Compact).
+ * 
+ * Behavior:
+ *  - Memory is taken in chunks of CHUNK_SIZE bytes, which are aligned to their
+ *    size, and is handed out by bumping an offset in the current chunk.
+ *  - Each chunk counts its live allocations. An allocation finds its chunk by
+ *    its address, so it may be freed after the arena is gone. A chunk is
+ *    returned when the arena has moved on from it, and all of its allocations
+ *    were freed.
+ *  - An arena may be bound to a NUMA node, and then its chunks are placed on
+ *    that node (see NumaNode).
+ *  - An arena may be huge-paged, and then its chunks are carved out of regions
+ *    of HUGE_PAGE_SIZE bytes, which are backed by explicit huge pages if the
+ *    system has reserved them, or by transparent huge pages otherwise. A
+ *    region is unmapped when all of its chunks were returned.
+ *  - Allocations are serialized by a mutex, and deallocations are lock-free.
+ */
+class NodeArena {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The header of a chunk, at its beginning.
+     */
+    struct Chunk {
+
+        /**
+         * @brief The number of live allocations in the chunk, plus 1 while it
+         *        is the current chunk of an arena.
+         */
+        atomic<size_t> liveCount;
+
+        /**
+         * @brief The first chunk of the huge-page region that the chunk was
+         *        carved out of, or nullptr if it was allocated on its own.
+         */
+        Chunk* region;
+
+        /**
+         * @brief In the first chunk of a region, the number of its chunks that
+         *        were not returned yet. Not used otherwise.
+         */
+        atomic<size_t> regionChunks;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The NUMA node that the chunks are placed on, or -1 for the default
+     *        placement.
+     */
+    const int numaNode;
+
+    /**
+     * @brief True if the chunks are carved out of huge-page regions.
+     */
+    const bool isHugePaged;
+
+    /**
+     * @brief Serializes the allocations.
+     */
+    mutex allocationMutex;
+
+    /**
+     * @brief The chunk that allocations are taken from, or nullptr before the
+     *        first allocation.
+     */
+    Chunk* current;
+
+    /**
+     * @brief The number of bytes that are used in the current chunk, including
+     *        its header.
+     */
+    size_t used;
+
+    /**
+     * @brief The huge-page region that new chunks are carved out of, or nullptr
+     *        before the first one.
+     */
+    Chunk* region;
+
+    /**
+     * @brief The number of chunks that were carved out of the current region.
+     */
+    size_t regionUsed;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief A service method that allocates a new chunk, which is held by the
+     *        arena, on the arena's NUMA node.
+     * 
+     * @retval Chunk* The chunk.
+     */
+    Chunk* NewChunk();
+
+    /**
+     * @brief A service method that maps a new huge-page region, on the arena's
+     *        NUMA node, and initializes the region count of its first chunk.
+     * 
+     * @retval Chunk* The first chunk of the region.
+     */
+    Chunk* NewRegion() const;
+
+    /**
+     * @brief A service method that drops a single reference to a chunk, and
+     *        frees it if it was the last one.
+     * 
+     * @param chunk The chunk.
+     */
+    static void Release(Chunk* const chunk) noexcept;
+
+    /**
+     * @brief A service method that returns chunks to their huge-page region,
+     *        and unmaps it if they were the last ones.
+     * 
+     * @param region The first chunk of the region.
+     * @param chunks The number of chunks.
+     */
+    static void ReleaseRegion(Chunk* const region,
+                              const size_t chunks) noexcept;
+
+/**-----------------------------------------------------------------------------
+ * Public Definitions:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The size of a chunk, in bytes (a power of 2).
+     */
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+    /**
+     * @brief The size of a huge page, and of a huge-page region, in bytes (a
+     *        multiple of CHUNK_SIZE).
+     */
+    static constexpr size_t HUGE_PAGE_SIZE = 1 << 21;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The arena's constructor. No memory is taken before the first
+     *        allocation.
+     * 
+     * @param in_numaNode The NUMA node to place the chunks on, or -1 for the
+     *                    default placement (the node of the thread that first
+     *                    touches each page).
+     * @param in_isHugePaged True to carve the chunks out of huge-page regions.
+     *                       Ignored if the system has no huge pages (see
+     *                       LIST_HAS_HUGE_PAGES).
+     */
+    explicit NodeArena(const int in_numaNode = -1,
+                       const bool in_isHugePaged = false) noexcept;
+
+    /**
+     * @brief The arena's destructor. The allocations stay valid until they are
+     *        freed.
+     */
+    ~NodeArena() noexcept;
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    /**
+     * @brief Allocates memory right after the previous allocation, or at the
+     *        beginning of a new chunk if it does not fit.
+     * 
+     * @attention It is assumed that the alignment is a power of 2, and that
+     *            the size is much smaller than a chunk.
+     * 
+     * @param size      The size of the allocation, in bytes.
+     * @param alignment The alignment of the allocation, in bytes.
+     * 
+     * @retval void* The allocation.
+     */
+    void* Allocate(const size_t size, const size_t alignment);
+
+    /**
+     * @brief Frees an allocation of any arena.
+     * 
+     * @param pointer The allocation.
+     */
+    static void Deallocate(void* const pointer) noexcept;
+};
+
+/**
+ * @brief A standard allocator over a node arena, for allocate_shared.
+ *        Allocations are freed into their chunks, so copies of the allocator
+ *        (such as the one a shared pointer keeps) may outlive the arena.
+ */
+template<typename T>
+class ArenaAllocator {
+
+    template<typename U>
+    friend class ArenaAllocator;
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The arena to allocate from. Not used for deallocations.
+     */
+    NodeArena* arena;
+
+/**-----------------------------------------------------------------------------
+ * Public Definitions:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    typedef T value_type;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The allocator's constructor.
+     * 
+     * @param in_arena The arena to allocate from.
+     */
+    explicit ArenaAllocator(NodeArena& in_arena) noexcept : arena(&in_arena) {
+    }
+
+    /**
+     * @brief Rebinds an allocator of another type to the same arena.
+     * 
+     * @param other The other allocator.
+     */
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept :
+                                                        arena(other.arena) {
+    }
+
+    /**
+     * @brief Allocates memory for objects.
+     * 
+     * @param n The number of objects.
+     * 
+     * @retval T* The allocation.
+     */
+    T* allocate(const size_t n) {
+        return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Frees memory of objects.
+     * 
+     * @param pointer The allocation.
+     */
+    void deallocate(T* const pointer, const size_t) noexcept {
+        NodeArena::Deallocate(pointer);
+    }
+
+    /**
+     * @brief Allocators of the same arena are equal.
+     */
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena != other.arena;
+    }
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* NODE_ARENA_H_ */
\ No newline at end of file
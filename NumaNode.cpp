@@ -0,0 +1,194 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: NumaNode.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "NumaNode.h"
+
+#ifdef LIST_HAS_NUMA
+
+#include <numaif.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::ifstream;
+using std::istringstream;
+using std::string;
+using std::vector;
+using std::to_string;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+namespace {
+
+/**
+ * @brief The largest NUMA node that the masks of the system calls hold.
+ */
+constexpr unsigned int MAX_NODES = 1024;
+
+/**
+ * @brief The number of bits in a word of a node mask.
+ */
+constexpr unsigned int WORD_BITS = 8 * sizeof(unsigned long);
+
+/**
+ * @brief Reads a list of numbers from a file in the format of the kernel's
+ *        sysfs lists (such as "0-3,8-11").
+ * 
+ * @param path The file.
+ * 
+ * @retval vector<unsigned int> The numbers, or an empty list if the file
+ *                              could not be read.
+ */
+vector<unsigned int> ReadList(const string& path) {
+    vector<unsigned int> numbers;
+    ifstream file(path);
+    string range;
+    while(getline(file, range, ',')) {
+        istringstream stream(range);
+        unsigned int first(0), last(0);
+        char dash('\0');
+        if(!(stream >> first)) break;
+        last = stream >> dash >> last ? last : first;
+        for(unsigned int number = first; number <= last; ++number) {
+            numbers.push_back(number);
+        }
+    }
+    return numbers;
+}
+
+} // namespace
+
+#endif /* LIST_HAS_NUMA */
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * NumaNode:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+#ifdef LIST_HAS_NUMA
+
+unsigned int NumaNode::Count() noexcept {
+    static const unsigned int count([]() noexcept {
+        try {
+            const vector<unsigned int> nodes(
+                                ReadList("/sys/devices/system/node/online"));
+            return nodes.empty() ? 1 : nodes.back() + 1;
+        } catch(...) {
+            return 1U;
+        }
+    }());
+    return count;
+}
+
+int NumaNode::Current() noexcept {
+    unsigned int cpu(0), node(0);
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+    return static_cast<int>(node);
+}
+
+int NumaNode::Of(const void* const address) noexcept {
+    int node(-1);
+    if(syscall(SYS_get_mempolicy,
+               &node,
+               nullptr,
+               0,
+               address,
+               MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+bool NumaNode::Bind(void* const memory,
+                    const size_t size,
+                    const int node) noexcept {
+    if(node < 0 || static_cast<unsigned int>(node) >= MAX_NODES) return false;
+
+    const unsigned int bit(static_cast<unsigned int>(node));
+    unsigned long mask[MAX_NODES / WORD_BITS] = {};
+    mask[bit / WORD_BITS] = 1UL << (bit % WORD_BITS);
+    return syscall(SYS_mbind,
+                   memory,
+                   size,
+                   MPOL_PREFERRED,
+                   mask,
+                   MAX_NODES + 1,
+                   MPOL_MF_MOVE) == 0;
+}
+
+bool NumaNode::Pin(const int node) noexcept {
+    if(node < 0) return false;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    try {
+        for(const unsigned int cpu :
+                    ReadList("/sys/devices/system/node/node" + \
+                             to_string(node) + "/cpulist")) {
+            if(cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+        }
+    } catch(...) {
+        return false;
+    }
+    return CPU_COUNT(&cpus) > 0 && \
+           sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+#else
+
+unsigned int NumaNode::Count() noexcept {
+    return 1;
+}
+
+int NumaNode::Current() noexcept {
+    return 0;
+}
+
+int NumaNode::Of(const void* const) noexcept {
+    return -1;
+}
+
+bool NumaNode::Bind(void* const, const size_t, const int) noexcept {
+    return false;
+}
+
+bool NumaNode::Pin(const int) noexcept {
+    return false;
+}
+
+#endif /* LIST_HAS_NUMA */
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,123 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: NumaNode.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef NUMA_NODE_H_
+#define NUMA_NODE_H_
+
+/**=============================================================================
+ * Definitions:
+ * ===========================================================================*/
+
+/**
+ * @brief Defined when the system has the NUMA memory policy interface (Linux,
+ *        with the libnuma headers). Otherwise, the system is treated as a
+ *        single NUMA node, and memory is placed by the default policy.
+ */
+#if defined(__linux__) && __has_include(<numaif.h>)
+#define LIST_HAS_NUMA
+#endif
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include <cstddef>
+
+using std::size_t;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief Queries and placement on the NUMA nodes of the system.
+ * 
+ * Behavior:
+ *  - The memory policy system calls are made directly, so libnuma does not
+ *    need to be linked.
+ *  - Without NUMA support, there is a single node (0), and placement requests
+ *    fail without any effect.
+ */
+class NumaNode {
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief Returns the number of NUMA nodes of the system.
+     * 
+     * @retval unsigned int The number of nodes (at least 1).
+     */
+    static unsigned int Count() noexcept;
+
+    /**
+     * @brief Returns the NUMA node of the CPU that the calling thread runs on.
+     *        Unless the thread is pinned, it may move right afterwards.
+     * 
+     * @retval int The node.
+     */
+    static int Current() noexcept;
+
+    /**
+     * @brief Returns the NUMA node that holds a page of memory.
+     * 
+     * @param address An address in the page.
+     * 
+     * @retval int The node, or -1 if the page was never touched or it is
+     *             unknown.
+     */
+    static int Of(const void* const address) noexcept;
+
+    /**
+     * @brief Asks to place a range of memory on a NUMA node. Pages that were
+     *        already touched are moved, and others are placed there when they
+     *        are first touched. If the node is out of memory, other nodes are
+     *        used.
+     * 
+     * @attention It is assumed that the range is aligned to pages.
+     * 
+     * @param memory The beginning of the range.
+     * @param size   The size of the range, in bytes.
+     * @param node   The node.
+     * 
+     * @retval true  If the policy was set.
+     * @retval false Otherwise.
+     */
+    static bool Bind(void* const memory,
+                     const size_t size,
+                     const int node) noexcept;
+
+    /**
+     * @brief Pins the calling thread to the CPUs of a NUMA node.
+     * 
+     * @param node The node.
+     * 
+     * @retval true  If the thread was pinned.
+     * @retval false Otherwise.
+     */
+    static bool Pin(const int node) noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* NUMA_NODE_H_ */
\ No newline at end of file
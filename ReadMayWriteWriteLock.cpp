@@ -21,12 +21,22 @@
  * ===========================================================================*/
 
 #include "ReadMayWriteWriteLock.h"
+#include "ThreadSlot.h"
+#include <algorithm>
 #include <cassert>
 
 using std::scoped_lock;
 using std::make_tuple;
 using std::make_shared;
 using std::get;
+using std::find_if;
+using std::min;
+using std::cv_status;
+using std::this_thread::yield;
+using std::chrono::steady_clock;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_relaxed;
 
 /**=============================================================================
  * Declarations:
@@ -34,6 +44,28 @@ using std::get;
 
 typedef Read_MayWrite_Write_Lock Lock;
 
+namespace {
+
+/**
+ * @brief The log2 of the number of entries in the visible readers table.
+ */
+constexpr unsigned int VISIBLE_READERS_BITS = 12;
+
+/**
+ * @brief How many times the last revocation took, the read bias of a lock is
+ *        not set again.
+ */
+constexpr int BIAS_INHIBIT_FACTOR = 9;
+
+/**
+ * @brief The visible readers table, shared by all the read-biased locks. A
+ *        biased reader publishes its lock address and thread slot in the entry
+ *        its pair hashes to, and clears it on release. A zero entry is free.
+ */
+atomic<uint64_t> visibleReaders[1U << VISIBLE_READERS_BITS];
+
+} // namespace
+
 /*==============================================================================
  * Implementation:
  *============================================================================*/
@@ -45,29 +77,30 @@ typedef Read_MayWrite_Write_Lock Lock;
 /* private:
  **********/
 
-bool Lock::CanReaderAcquireLock() const noexcept{
-    return !isWriterHolding;
+bool Lock::CanReaderAcquireLock(const uint64_t word) noexcept{
+    return (word & WRITER) == 0;
 }
 
-bool Lock::CanMayWriterAcquireLock() const noexcept {
-    return mayWriterThreadId == thread::id() && CanReaderAcquireLock();
+bool Lock::CanMayWriterAcquireLock(const uint64_t word) noexcept {
+    return (word & MAY_WRITER) == 0 && CanReaderAcquireLock(word);
 }
 
-bool Lock::CanWriterAcquireLock() const noexcept {
-    return readersNumber == 0 && CanMayWriterAcquireLock();
+bool Lock::CanWriterAcquireLock(const uint64_t word) noexcept {
+    return (word & READERS_MASK) == 0 && CanMayWriterAcquireLock(word);
 }
 
-bool Lock::CanAcquireLock(const Operation operation) const noexcept {
+bool Lock::CanAcquireLock(const Operation operation,
+                          const uint64_t word) noexcept {
     bool canAcquireLock(true);
     switch(operation) {
         case READ:
-            canAcquireLock = CanReaderAcquireLock();
+            canAcquireLock = CanReaderAcquireLock(word);
             break;
         case MAY_WRITE:
-            canAcquireLock = CanMayWriterAcquireLock();
+            canAcquireLock = CanMayWriterAcquireLock(word);
             break;
         case WRITE:
-            canAcquireLock = CanWriterAcquireLock();
+            canAcquireLock = CanWriterAcquireLock(word);
             break;
         default:
             // We compile with -Wswitch-default and -Werror.
@@ -79,11 +112,124 @@ bool Lock::CanAcquireLock(const Operation operation) const noexcept {
     return canAcquireLock;
 }
 
+uint64_t Lock::Acquisition(const Operation operation,
+                           const void* holder) noexcept {
+    static_assert(ThreadSlot::MAX_SLOTS <= ASYNC_SLOT,
+                  "Thread slots fit in the lock word, below ASYNC_SLOT");
+
+    uint64_t acquisition(0);
+    switch(operation) {
+        case READ:
+            acquisition = READER;
+            break;
+        case MAY_WRITE:
+            acquisition = MayWriterBits(holder == nullptr ?
+                                            ThreadSlot::Index() :
+                                            ASYNC_SLOT);
+            break;
+        case WRITE:
+            acquisition = WRITER;
+            break;
+        default:
+            // We compile with -Wswitch-default and -Werror.
+            assert(operation != READ      && \
+                   operation != MAY_WRITE && \
+                   operation != WRITE);
+    }
+    return acquisition;
+}
+
+atomic<uint64_t>& Lock::VisibleReader(uint64_t& value) const noexcept {
+    const uint64_t slot(ThreadSlot::Index());
+    const uint64_t address(reinterpret_cast<uintptr_t>(this));
+
+    // User space addresses fit in 48 bits, and slots in 16 bits.
+    assert((address >> SLOT_SHIFT) == 0 && slot <= ASYNC_SLOT);
+    value = (address << (64 - SLOT_SHIFT)) | slot;
+
+    const uint64_t hash((address ^ (slot << SLOT_SHIFT)) * 0x9E3779B97F4A7C15);
+    return visibleReaders[hash >> (64 - VISIBLE_READERS_BITS)];
+}
+
+bool Lock::TryBiasedRead() noexcept {
+    if(!isReadBiased || \
+       (lockWord.load(memory_order_relaxed) & READ_BIAS) == 0) {
+        return false;
+    }
+
+    // The entry may be taken by another pair, or by this thread for this lock.
+    uint64_t value(0);
+    atomic<uint64_t>& entry(VisibleReader(value));
+    uint64_t freeEntry(0);
+    if(!entry.compare_exchange_strong(freeEntry, value)) return false;
+
+    // Either the revoking writer sees the entry, or the reader sees that the
+    // bias was revoked. Waiters are not bypassed.
+    if((lockWord.load() & (READ_BIAS | HAS_WAITERS)) == READ_BIAS) return true;
+
+    entry.store(0, memory_order_release);
+    return false;
+}
+
+bool Lock::TryBiasedRelease() noexcept {
+    if(!isReadBiased) return false;
+
+    uint64_t value(0);
+    atomic<uint64_t>& entry(VisibleReader(value));
+    if(entry.load(memory_order_relaxed) != value) return false;
+
+    entry.store(0, memory_order_release);
+    return true;
+}
+
+void Lock::RestoreReadBias() noexcept {
+    if(!isReadBiased) return;
+
+    const uint64_t word(lockWord.load(memory_order_relaxed));
+    if((word & (READ_BIAS | HAS_WAITERS)) != 0 || \
+       steady_clock::now().time_since_epoch().count() < \
+                                inhibitBiasUntil.load(memory_order_relaxed)) {
+        return;
+    }
+
+    lockWord.fetch_or(READ_BIAS);
+}
+
+void Lock::RevokeReadBias() noexcept {
+    // The bias is set only by readers that hold the lock, so it cannot be set
+    // while the writer holds it.
+    if(!isReadBiased || \
+       (lockWord.load(memory_order_relaxed) & READ_BIAS) == 0) {
+        return;
+    }
+
+    const steady_clock::time_point start(steady_clock::now());
+    lockWord.fetch_and(~READ_BIAS);
+
+    const uint64_t address(reinterpret_cast<uintptr_t>(this));
+    for(atomic<uint64_t>& entry : visibleReaders) {
+        while((entry.load() >> (64 - SLOT_SHIFT)) == address) {
+            yield();
+        }
+    }
+
+    const steady_clock::time_point end(steady_clock::now());
+    inhibitBiasUntil.store((end + (end - start) * BIAS_INHIBIT_FACTOR).
+                                                   time_since_epoch().count(),
+                           memory_order_relaxed);
+}
+
+uint64_t Lock::MayWriterBits(const uint64_t slot) noexcept {
+    return READER + MAY_WRITER + (slot << SLOT_SHIFT);
+}
+
 void Lock::InsertConditionTuple(const Operation operation,
                                 const bool isVIP/* = false*/) {
     ConditionTuple conditionTuple(make_tuple(make_shared<condition_variable>(),
                                              operation,
-                                             1));
+                                             1,
+                                             nullptr,
+                                             nullptr));
     if(isVIP) {
         threadQueue.push_front(std::move(conditionTuple));
     } else {
@@ -96,17 +242,18 @@ bool Lock::ShouldThreadWait(const Operation operation) {
 
     switch(threadQueue.size()) {
         case 0:
-            shouldThreadWait = !CanAcquireLock(operation);
+            shouldThreadWait = !AcquireOrMarkWaiting(operation, nullptr);
             break;
         case 1:
             shouldThreadWait = operation != READ                   || \
                                get<1>(threadQueue.front()) != READ || \
-                               !CanAcquireLock(operation);
+                               !CanAcquireLock(operation, lockWord.load());
+            if(!shouldThreadWait) Acquire(operation, nullptr);
             [[fallthrough]];
         default:
             if(operation == READ && shouldThreadWait) {
                 ConditionTuple& backTuple(threadQueue.back());
-                if(get<1>(backTuple) == READ) {
+                if(get<1>(backTuple) == READ && get<0>(backTuple) != nullptr) {
                     unsigned int& readTupleCounter(get<2>(backTuple));
                     assert(readTupleCounter > 0);
                     ++readTupleCounter;
@@ -126,8 +273,46 @@ bool Lock::ShouldThreadWait(const Operation operation) {
     return shouldThreadWait;
 }
 
-void Lock::Wait(const Operation operation, unique_lock<mutex>& lock) noexcept {
-    if(!ShouldThreadWait(operation)) return;
+bool Lock::Spin(const Operation operation,
+                const bool isUpgrade/* = false*/) noexcept {
+    static const bool isMultiCore(thread::hardware_concurrency() > 1);
+    static const unsigned int MAX_BACKOFF(64);
+
+    if(maxSpinRounds == 0 || !isMultiCore) return false;
+
+    // As in adaptive mutexes, a lock that was acquired after a few rounds
+    // lately is worth a few more; a lock that was not is worth less.
+    const int estimate(spinEstimate.load(memory_order_relaxed));
+    const int rounds(min(static_cast<int>(maxSpinRounds), estimate * 2 + 10));
+    int round(0);
+    unsigned int backoff(1);
+    bool isAcquired(false);
+    while(!isAcquired && round < rounds && \
+          (lockWord.load(memory_order_relaxed) & HAS_WAITERS) == 0) {
+        for(unsigned int i = 0; i < backoff; ++i) {
+            CpuRelax();
+        }
+        backoff = min(backoff * 2, MAX_BACKOFF);
+        ++round;
+
+        isAcquired = isUpgrade ? UpgradeUnlessWaiting() :
+                                 AcquireUnlessWaiting(operation);
+    }
+
+    spinEstimate.store(estimate + (round - estimate) / 8, memory_order_relaxed);
+    return isAcquired;
+}
+
+void Lock::CpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+bool Lock::Wait(const Operation operation, unique_lock<mutex>& lock) noexcept {
+    if(!ShouldThreadWait(operation)) return false;
 
     const ConditionPtr& conditionPtr(get<0>(threadQueue.back()));
     do {
@@ -137,132 +322,466 @@ void Lock::Wait(const Operation operation, unique_lock<mutex>& lock) noexcept {
     // SPURIOUS WAKEUPS, which can awaken threads even when their condition
     // variable was not signaled. :/
     } while(get<0>(threadQueue.front()) != conditionPtr || \
-            !CanAcquireLock(operation));
-    
+            !CanAcquireLock(operation, lockWord.load()));
+
+    // The lock is acquired before leaving the queue, as HAS_WAITERS may be
+    // cleared then.
+    Acquire(operation, nullptr);
+    return LeaveQueue(operation);
+}
+
+bool Lock::LeaveQueue(const Operation operation) noexcept {
     if(operation == READ) {
         ConditionTuple& readTuple(threadQueue.front());
         unsigned int& readTupleCounter(get<2>(readTuple));
         assert(readTupleCounter > 0);
         --readTupleCounter;
 
-        if(readTupleCounter != 0) return;
+        if(readTupleCounter != 0) return false;
     }
 
     threadQueue.pop_front();
+    ClearWaitersIfEmpty();
 
     // A philanthropic piece of code. Readers an may-writers take care of each
     // other. We prefer to check the condition instead of awakening a thread
     // and let it check the condition by itself just to return to waiting.
-    if(operation != WRITE) TryNotifyingNext();
+    // This is done by the caller, after it acquired the lock, so asynchronous
+    // waiters are not granted a lock that it is about to take.
+    return operation != WRITE;
+}
+
+void Lock::AbandonQueue(const ConditionPtr& conditionPtr) noexcept {
+    const auto abandoned(find_if(threadQueue.begin(),
+                                 threadQueue.end(),
+                                 [&conditionPtr](const ConditionTuple& tuple) {
+        return get<0>(tuple) == conditionPtr;
+    }));
+    assert(abandoned != threadQueue.end());
+
+    // Other readers may still wait on the same condition variable.
+    unsigned int& tupleCounter(get<2>(*abandoned));
+    assert(tupleCounter > 0);
+    --tupleCounter;
+    if(tupleCounter == 0) threadQueue.erase(abandoned);
+    ClearWaitersIfEmpty();
+}
+
+void Lock::ClearWaitersIfEmpty() noexcept {
+    if(threadQueue.empty()) lockWord.fetch_and(~HAS_WAITERS);
+}
+
+bool Lock::AcquireUnlessWaiting(const Operation operation) noexcept {
+    const uint64_t acquisition(Acquisition(operation, nullptr));
+    uint64_t word(lockWord.load(memory_order_relaxed));
+    while((word & HAS_WAITERS) == 0 && CanAcquireLock(operation, word)) {
+        if(lockWord.compare_exchange_weak(word,
+                                          word + acquisition,
+                                          memory_order_acquire,
+                                          memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Lock::AcquireOrMarkWaiting(const Operation operation,
+                                const void* holder) {
+    const uint64_t acquisition(Acquisition(operation, holder));
+    uint64_t word(lockWord.load());
+    while(true) {
+        if((word & HAS_WAITERS) != 0) return false;
+
+        const bool canAcquireLock(CanAcquireLock(operation, word));
+        if(lockWord.compare_exchange_weak(word,
+                                          canAcquireLock ?
+                                              word + acquisition :
+                                              word | HAS_WAITERS)) {
+            if(canAcquireLock && operation == MAY_WRITE) {
+                asyncMayWriter = holder;
+            }
+            return canAcquireLock;
+        }
+    }
+}
+
+void Lock::Acquire(const Operation operation, const void* holder) noexcept {
+    assert((lockWord.load() & HAS_WAITERS) != 0);
+    assert(CanAcquireLock(operation, lockWord.load()));
+
+    // Only releases may change the word meanwhile, and they do not touch the
+    // acquired bits, so an addition is enough.
+    lockWord.fetch_add(Acquisition(operation, holder));
+    if(operation == MAY_WRITE) asyncMayWriter = holder;
+}
+
+bool Lock::UpgradeUnlessWaiting() noexcept {
+    const uint64_t mayWriterBits(MayWriterBits(ThreadSlot::Index()));
+    uint64_t word(lockWord.load(memory_order_relaxed));
+    while((word & HAS_WAITERS) == 0 && (word & READERS_MASK) == READER) {
+        assert((word & ~(HAS_WAITERS | READ_BIAS)) == mayWriterBits);
+        if(lockWord.compare_exchange_weak(word,
+                                          word - mayWriterBits + WRITER,
+                                          memory_order_acquire,
+                                          memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Lock::UpgradeOrMarkWaiting(const uint64_t slot) noexcept {
+    const uint64_t mayWriterBits(MayWriterBits(slot));
+    uint64_t word(lockWord.load());
+    while(true) {
+        assert((word & MAY_WRITER) != 0 && (word >> SLOT_SHIFT) == slot);
+        const uint64_t newWord(word - mayWriterBits);
+        const bool canUpgrade(CanWriterAcquireLock(newWord));
+        if(lockWord.compare_exchange_weak(word,
+                                          canUpgrade ? newWord + WRITER :
+                                                       newWord | HAS_WAITERS)) {
+            return canUpgrade;
+        }
+    }
+}
+
+bool Lock::ReleaseShared(const uint64_t mayWriterBits) noexcept {
+    const uint64_t word(lockWord.fetch_sub(mayWriterBits != 0 ? mayWriterBits :
+                                                                READER,
+                                           memory_order_release));
+    assert((word & READERS_MASK) > 0);
+
+    // Only* a may-writer or a writer can be notified here. The
+    // TryNotifyingNext() method must be used, because there may be a scenario
+    // when a may-writer just released his lock, but next thread in-line is a
+    // writer. A check for this must be made before waking the writer.
+    //
+    // * A possible case that can occur is a double notification by a
+    //   may-writer of already awoken readers.
+    return (word & HAS_WAITERS) != 0 && \
+           (mayWriterBits != 0 || (word & READERS_MASK) == READER);
 }
 
-void Lock::TryNotifyingNext() const noexcept {
-    if(!threadQueue.empty()) {
-        const ConditionTuple& frontTuple(threadQueue.front());
+void Lock::TryNotifyingNext(list<ConditionTuple>& granted) noexcept {
+    while(!threadQueue.empty()) {
+        ConditionTuple& frontTuple(threadQueue.front());
         const Operation operation(get<1>(frontTuple));
-        if(CanAcquireLock(operation)) {
+        if(!CanAcquireLock(operation, lockWord.load())) return;
+
+        if(get<0>(frontTuple) != nullptr) {
             get<0>(frontTuple)->notify_all();
+            return;
+        }
+
+        Acquire(operation, get<3>(frontTuple));
+        granted.splice(granted.end(), threadQueue, threadQueue.begin());
+        ClearWaitersIfEmpty();
+    }
+}
+
+void Lock::NotifyNextAndUnlock(unique_lock<mutex>& lock) noexcept {
+    list<ConditionTuple> granted;
+    TryNotifyingNext(granted);
+    lock.unlock();
+
+    for(ConditionTuple& grantedTuple : granted) {
+        if(get<1>(grantedTuple) == WRITE) RevokeReadBias();
+        get<4>(grantedTuple)();
+    }
+}
+
+void Lock::NotifyNext() noexcept {
+    unique_lock<mutex> lock(internalMutex);
+    NotifyNextAndUnlock(lock);
+}
+
+bool Lock::LockOrEnqueue(const Operation operation,
+                         const void* holder,
+                         function<void()>&& onAcquired) {
+    scoped_lock<mutex> lock(internalMutex);
+
+    if(AcquireOrMarkWaiting(operation, holder)) return true;
+
+    threadQueue.push_back(make_tuple(nullptr,
+                                     operation,
+                                     1,
+                                     holder,
+                                     std::move(onAcquired)));
+    return false;
+}
+
+bool Lock::LockFor(const Operation operation, const nanoseconds timeout) {
+    if(AcquireUnlessWaiting(operation)) return true;
+    if(timeout <= nanoseconds::zero()) return false;
+
+    unique_lock<mutex> lock(internalMutex);
+
+    if(!ShouldThreadWait(operation)) return true;
+
+    const steady_clock::time_point deadline(steady_clock::now() + timeout);
+    const ConditionPtr conditionPtr(get<0>(threadQueue.back()));
+    while(get<0>(threadQueue.front()) != conditionPtr || \
+          !CanAcquireLock(operation, lockWord.load())) {
+        const bool isTimedOut(conditionPtr->wait_until(lock, deadline) == \
+                              cv_status::timeout);
+
+        // The condition is checked again after a timeout, as the thread may
+        // have been notified just in time.
+        if(isTimedOut && (get<0>(threadQueue.front()) != conditionPtr || \
+                          !CanAcquireLock(operation, lockWord.load()))) {
+            AbandonQueue(conditionPtr);
+            // The thread may have blocked the ones behind it.
+            NotifyNextAndUnlock(lock);
+            return false;
         }
     }
+
+    Acquire(operation, nullptr);
+    if(LeaveQueue(operation)) NotifyNextAndUnlock(lock);
+    return true;
 }
 
 /* public:
  *********/
 
-Lock::Read_MayWrite_Write_Lock() : readersNumber(0), isWriterHolding(false) {
+Lock::Read_MayWrite_Write_Lock(const unsigned int in_maxSpinRounds/* = 0*/,
+                               const bool in_isReadBiased/* = false*/) :
+                                            lockWord(0),
+                                            asyncMayWriter(nullptr),
+                                            maxSpinRounds(in_maxSpinRounds),
+                                            spinEstimate(0),
+                                            isReadBiased(in_isReadBiased),
+                                            inhibitBiasUntil(0) {
 }
 
 void Lock::LockRead() {
-    unique_lock<mutex> lock(internalMutex);
+    if(TryBiasedRead()) return;
 
-    Wait(READ, lock);
+    if(!AcquireUnlessWaiting(READ) && !Spin(READ)) {
+        unique_lock<mutex> lock(internalMutex);
 
-    ++readersNumber;
+        if(Wait(READ, lock)) NotifyNextAndUnlock(lock);
+    }
+    RestoreReadBias();
 }
 
 void Lock::LockMayWrite() {
-    unique_lock<mutex> lock(internalMutex);
+    if(AcquireUnlessWaiting(MAY_WRITE) || Spin(MAY_WRITE)) return;
 
-    Wait(MAY_WRITE, lock);
+    unique_lock<mutex> lock(internalMutex);
 
-    ++readersNumber;
-    assert(mayWriterThreadId == thread::id());
-    mayWriterThreadId = std::this_thread::get_id();
+    if(Wait(MAY_WRITE, lock)) NotifyNextAndUnlock(lock);
 }
 
 void Lock::LockWrite() {
+    if(!AcquireUnlessWaiting(WRITE) && !Spin(WRITE)) {
+        unique_lock<mutex> lock(internalMutex);
+
+        Wait(WRITE, lock);
+    }
+    RevokeReadBias();
+}
+
+void Lock::UpgradeLock() {
+    // The may-write mode is kept while spinning, so no other may-writer can
+    // take the lock meanwhile.
+    if(UpgradeUnlessWaiting() || Spin(WRITE, /*isUpgrade = */true)) {
+        RevokeReadBias();
+        return;
+    }
+
     unique_lock<mutex> lock(internalMutex);
 
-    Wait(WRITE, lock);
+    // The biased readers do not need the mutex to leave, so it may be held
+    // while they are waited for.
+    if(UpgradeOrMarkWaiting(ThreadSlot::Index())) {
+        RevokeReadBias();
+        return;
+    }
+
+    InsertConditionTuple(WRITE, /*isVIP = */true);
+
+    const ConditionPtr& conditionPtr(get<0>(threadQueue.front()));
+    do {
+        conditionPtr->wait(lock);
+    // In an ideal world, we could have avoided this check, as we manage a
+    // queue and control who is being notified and when. But, in our world,
+    // there are SPURIOUS WAKEUPS, which can awaken threads even when their
+    // condition variable was not signaled. :/
+    } while(!CanWriterAcquireLock(lockWord.load()));
 
-    assert(!isWriterHolding);
-    isWriterHolding = true;
+    Acquire(WRITE, nullptr);
+    threadQueue.pop_front();
+    ClearWaitersIfEmpty();
+    RevokeReadBias();
 }
 
-void Lock::UpgradeLock() {
+bool Lock::TryLockRead() {
+    return TryLockReadFor(nanoseconds::zero());
+}
+
+bool Lock::TryLockMayWrite() {
+    return LockFor(MAY_WRITE, nanoseconds::zero());
+}
+
+bool Lock::TryLockWrite() {
+    return TryLockWriteFor(nanoseconds::zero());
+}
+
+bool Lock::TryUpgradeLock() {
+    return TryUpgradeLockFor(nanoseconds::zero());
+}
+
+bool Lock::TryLockReadFor(const nanoseconds timeout) {
+    if(TryBiasedRead()) return true;
+    if(!LockFor(READ, timeout)) return false;
+
+    RestoreReadBias();
+    return true;
+}
+
+bool Lock::TryLockMayWriteFor(const nanoseconds timeout) {
+    return LockFor(MAY_WRITE, timeout);
+}
+
+bool Lock::TryLockWriteFor(const nanoseconds timeout) {
+    if(!LockFor(WRITE, timeout)) return false;
+
+    RevokeReadBias();
+    return true;
+}
+
+bool Lock::TryUpgradeLockFor(const nanoseconds timeout) {
+    if(UpgradeUnlessWaiting()) {
+        RevokeReadBias();
+        return true;
+    }
+    if(timeout <= nanoseconds::zero()) return false;
+
     unique_lock<mutex> lock(internalMutex);
-    
-    assert(readersNumber > 0);
-    --readersNumber;
-    assert(mayWriterThreadId == std::this_thread::get_id());
-    mayWriterThreadId = thread::id();
-    
-    if(!CanWriterAcquireLock()) {
-        InsertConditionTuple(WRITE, /*isVIP = */true);
-        
-        const ConditionPtr& conditionPtr(get<0>(threadQueue.front()));
-        do {
-            conditionPtr->wait(lock);
-        // In an ideal world, we could have avoided this check, as we manage a
-        // queue and control who is being notified and when. But, in our world,
-        // there are SPURIOUS WAKEUPS, which can awaken threads even when their
-        // condition variable was not signaled. :/
-        } while(!CanWriterAcquireLock());
 
+    const uint64_t slot(ThreadSlot::Index());
+    if(UpgradeOrMarkWaiting(slot)) {
+        RevokeReadBias();
+        return true;
+    }
+
+    const steady_clock::time_point deadline(steady_clock::now() + timeout);
+    InsertConditionTuple(WRITE, /*isVIP = */true);
+
+    // Only the may-writer pushes to the front of the queue, so the tuple stays
+    // there.
+    const ConditionPtr conditionPtr(get<0>(threadQueue.front()));
+    while(!CanWriterAcquireLock(lockWord.load())) {
+        if(conditionPtr->wait_until(lock, deadline) == cv_status::timeout) {
+            break;
+        }
+    }
+
+    if(CanWriterAcquireLock(lockWord.load())) {
+        Acquire(WRITE, nullptr);
         threadQueue.pop_front();
+        ClearWaitersIfEmpty();
+        RevokeReadBias();
+        return true;
     }
 
-    assert(!isWriterHolding);
-    isWriterHolding = true;
+    // The may-write mode is taken back. No one could have acquired it
+    // meanwhile, as HAS_WAITERS was set, and the front of the queue was the
+    // upgrade.
+    lockWord.fetch_add(MayWriterBits(slot));
+    threadQueue.pop_front();
+    ClearWaitersIfEmpty();
+    NotifyNextAndUnlock(lock);
+    return false;
+}
+
+void Lock::DowngradeToMayWrite() noexcept {
+    // The writer bit is replaced by the may-writer bits. Only readers can be
+    // let in.
+    const uint64_t mayWriterBits(MayWriterBits(ThreadSlot::Index()));
+    const uint64_t word(lockWord.fetch_add(mayWriterBits - WRITER));
+    assert((word & WRITER) != 0);
+    if((word & HAS_WAITERS) != 0) NotifyNext();
+}
+
+void Lock::DowngradeToRead() noexcept {
+    // A may-writer can be let in, followed by more readers.
+    const uint64_t mayWriterBits(MayWriterBits(ThreadSlot::Index()));
+    const uint64_t word(lockWord.fetch_sub(mayWriterBits - READER));
+    assert((word & MAY_WRITER) != 0);
+    if((word & HAS_WAITERS) != 0) NotifyNext();
 }
 
 void Lock::ReleaseSharedLock() noexcept {
+    // Only the thread itself can set or clear its slot as the may-writer.
+    const uint64_t slot(ThreadSlot::Index());
+    const uint64_t word(lockWord.load(memory_order_relaxed));
+    const bool isMayWriter((word & MAY_WRITER) != 0 && \
+                           (word >> SLOT_SHIFT) == slot);
+
+    if(!isMayWriter && TryBiasedRelease()) return;
+    if(ReleaseShared(isMayWriter ? MayWriterBits(slot) : 0)) NotifyNext();
+}
+
+bool Lock::LockReadOrEnqueue(function<void()> onAcquired) {
+    return LockOrEnqueue(READ, nullptr, std::move(onAcquired));
+}
+
+bool Lock::LockMayWriteOrEnqueue(const void* holder,
+                                 function<void()> onAcquired) {
+    return LockOrEnqueue(MAY_WRITE, holder, std::move(onAcquired));
+}
+
+bool Lock::LockWriteOrEnqueue(function<void()> onAcquired) {
+    if(!LockOrEnqueue(WRITE, nullptr, std::move(onAcquired))) return false;
+
+    RevokeReadBias();
+    return true;
+}
+
+bool Lock::UpgradeLockOrEnqueue(const void* holder,
+                                function<void()> onAcquired) {
     scoped_lock<mutex> lock(internalMutex);
 
-    assert(readersNumber > 0);
-    --readersNumber;
+    assert(asyncMayWriter == holder);
+    asyncMayWriter = nullptr;
 
-    if(mayWriterThreadId == std::this_thread::get_id()) {
-        mayWriterThreadId = thread::id();
-    } else {
-        if(readersNumber > 0) return;
+    if(UpgradeOrMarkWaiting(ASYNC_SLOT)) {
+        RevokeReadBias();
+        return true;
     }
 
-    TryNotifyingNext(); // Only* a may-writer or a writer can be notified here.
-                        // The TryNotifyingNext() method must be used, because
-                        // there may be a scenario when a may-writer just
-                        // released his lock, but next thread in-line is a
-                        // writer. A check for this must be made before waking
-                        // the writer.
-                        //
-                        // * A possible case that can occur is a double
-                        //   notification by a may-writer of already awoken
-                        //   readers.
+    threadQueue.push_front(make_tuple(nullptr,
+                                      WRITE,
+                                      1,
+                                      holder,
+                                      std::move(onAcquired)));
+    return false;
 }
 
-void Lock::ReleaseExclusiveLock() noexcept {
-    scoped_lock<mutex> lock(internalMutex);
+void Lock::ReleaseSharedLock(const void* holder) noexcept {
+    unique_lock<mutex> lock(internalMutex);
 
-    assert(isWriterHolding);
-    isWriterHolding = false;
+    const bool isMayWriter(asyncMayWriter == holder && \
+                           (lockWord.load() & MAY_WRITER) != 0 && \
+                           (lockWord.load() >> SLOT_SHIFT) == ASYNC_SLOT);
+    if(isMayWriter) asyncMayWriter = nullptr;
 
-    // No use of TryNotifyingNext() because no need for a check. Any thread next
-    // in-line can enter.
-    if(!threadQueue.empty()) {
-        get<0>(threadQueue.front())->notify_all();
+    if(ReleaseShared(isMayWriter ? MayWriterBits(ASYNC_SLOT) : 0)) {
+        NotifyNextAndUnlock(lock);
     }
 }
 
+void Lock::ReleaseExclusiveLock() noexcept {
+    const uint64_t word(lockWord.fetch_sub(WRITER, memory_order_release));
+    assert((word & WRITER) != 0);
+
+    // Any thread next in-line can enter, but asynchronous waiters must be
+    // granted the lock on their behalf.
+    if((word & HAS_WAITERS) != 0) NotifyNext();
+}
+
 /**=============================================================================
  * End of file
  * ===========================================================================*/
\ No newline at end of file
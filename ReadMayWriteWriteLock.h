@@ -29,6 +29,10 @@
 #include <list>
 #include <memory>
 #include <thread>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
 
 using std::condition_variable;
 using std::mutex;
@@ -37,6 +41,10 @@ using std::tuple;
 using std::list;
 using std::shared_ptr;
 using std::thread;
+using std::function;
+using std::atomic;
+using std::chrono::steady_clock;
+using std::chrono::nanoseconds;
 
 /**=============================================================================
  * Declarations:
@@ -46,6 +54,11 @@ using std::thread;
  * @brief A fair read/may-write/write lock class.
  * 
  * Behavior:
+ *  - The state of the lock is packed in a single 64-bit atomic word. While no
+ *    thread waits for the lock, acquiring and releasing it are a single atomic
+ *    operation. Otherwise, the requests are served in order through a queue.
+ *  - Optionally, readers are biased: they publish themselves in a global table
+ *    instead of writing the lock word, until a writer revokes the bias.
  *  - The lock is a fair lock. It implements a First-In-First-Out queue, with
  *    respect to arrival time of the threads.
  *  - An unlimited number of readers can acquire the lock (as long as it is
@@ -54,7 +67,7 @@ using std::thread;
  *    number of readers acquiring the lock simultaneously to a may-writer.
  *  - Only one writer may acquire the lock. When a writer has the lock, all
  *    other threads are blocked.
- *
+ * 
  * @attention There is no check for the validity of the requests. It is assumed
  *            that whoever initiates a request, has the lock in the right state.
  *            For example:
@@ -77,14 +90,120 @@ class Read_MayWrite_Write_Lock {
     enum Operation {READ, MAY_WRITE, WRITE};
 
     typedef shared_ptr<condition_variable> ConditionPtr;
-    typedef tuple<ConditionPtr, Operation, unsigned int> ConditionTuple;
+
+    /**
+     * @brief An entry of the thread queue: the condition variable, the mode,
+     *        the number of threads waiting on the condition variable, and for
+     *        asynchronous waiters (whose condition variable is nullptr) the
+     *        holder identifier and the function that resumes the waiter once
+     *        the lock was acquired on its behalf.
+     */
+    typedef tuple<ConditionPtr,
+                  Operation,
+                  unsigned int,
+                  const void*,
+                  function<void()>> ConditionTuple;
+
+    /**
+     * @brief The number of readers currently holding the lock (including the
+     *        may-writer!), in the lowest 32 bits of the lock word.
+     * 
+     * @remark Including the may-writer in this counting is not mandatory. It is
+     *         done solely for the case when all the readers release the lock
+     *         while there is still a may-writer holding it. In this case, the
+     *         last reader will not have to check whether a waiting thread
+     *         should be awakened, as a waiting thread can only be a may-writer
+     *         or a writer, which are not allowed to hold the lock.
+     */
+    static constexpr uint64_t READER = 1;
+    static constexpr uint64_t READERS_MASK = 0xFFFFFFFFULL;
+
+    /**
+     * @brief Set in the lock word while a writer is holding the lock.
+     */
+    static constexpr uint64_t WRITER = 1ULL << 32;
+
+    /**
+     * @brief Set in the lock word while a may-writer is holding the lock.
+     */
+    static constexpr uint64_t MAY_WRITER = 1ULL << 33;
+
+    /**
+     * @brief Set in the lock word while the thread queue is not empty. Then,
+     *        every acquisition goes through the internal mutex and the queue,
+     *        so it is fair, and every release wakes the next waiters.
+     */
+    static constexpr uint64_t HAS_WAITERS = 1ULL << 34;
+
+    /**
+     * @brief Set in the lock word while readers may acquire the lock by
+     *        publishing themselves in the visible readers table (see
+     *        TryBiasedRead), instead of incrementing the readers number.
+     */
+    static constexpr uint64_t READ_BIAS = 1ULL << 35;
+
+    /**
+     * @brief The slot of the may-writer is kept in the highest 16 bits of the
+     *        lock word. For a thread, this is its ThreadSlot index. For an
+     *        asynchronous holder, it is ASYNC_SLOT (see asyncMayWriter).
+     */
+    static constexpr unsigned int SLOT_SHIFT = 48;
+    static constexpr uint64_t ASYNC_SLOT = 0xFFFF;
 
 /**-----------------------------------------------------------------------------
  * Private Internal Variables:
  * ---------------------------------------------------------------------------*/
 
     /**
-     * @brief An internal mutex, to protect the internal variables.
+     * @brief The whole state of the lock, but for its waiters: readers number,
+     *        writer and may-writer flags, the may-writer's slot, and whether
+     *        there are waiters. Uncontended acquisitions and releases are a
+     *        single atomic operation on it, without the internal mutex.
+     *        While HAS_WAITERS is set, it is changed only under the internal
+     *        mutex, except for releases (which can only let more threads in).
+     */
+    atomic<uint64_t> lockWord;
+
+    /**
+     * @brief The identifier of the asynchronous holder of the lock in a
+     *        may-write mode, if any (any address that it owns). Protected by
+     *        the internal mutex.
+     */
+    const void* asyncMayWriter;
+
+    /**
+     * @brief The most backoff rounds a thread spins before it waits in the
+     *        thread queue (see Spin).
+     */
+    const unsigned int maxSpinRounds;
+
+    /**
+     * @brief A moving average of the rounds that spinning threads needed to
+     *        acquire the lock, which approximates how long the lock is held.
+     *        It bounds the next spin, so threads stop spinning on a lock that
+     *        is held for long.
+     */
+    atomic<int> spinEstimate;
+
+    /**
+     * @brief If true, readers are biased (see ListOptions::isReadBiased).
+     */
+    const bool isReadBiased;
+
+    /**
+     * @brief The time (in steady clock ticks) until which the read bias is not
+     *        set again, after a writer has revoked it. It is proportional to
+     *        the time the revocation took, so frequent writers turn the bias
+     *        off.
+     */
+    atomic<steady_clock::rep> inhibitBiasUntil;
+
+    /**
+     * @brief An internal mutex, to protect the thread queue, and to serialize
+     *        the contended acquisitions.
+     *        It and the queue are touched only under contention, so they come
+     *        after the fields that every acquisition uses, which share a cache
+     *        line with the lock word.
      */
     mutex internalMutex;
 
@@ -100,32 +219,6 @@ class Read_MayWrite_Write_Lock {
      */
     list<ConditionTuple> threadQueue;
 
-    /**
-     * @brief Number of readers currenty holding the lock (including the
-     *        may-writer!).
-     * 
-     * @remark Including the may-writer in this counting is not mandatory. It is
-     *         done solely for the case when all the readers release the lock
-     *         while there is still a may-writer holding it. In this case, the
-     *         last reader will not have to check whether a waiting thread
-     *         should be awakened, as a waiting thread can only be a may-writer
-     *         or a writer, which are not allowed to hold the lock.
-     */
-    unsigned int readersNumber;
-    
-    /**
-     * @brief A boolean that indicates whether a writer is currently holding the
-     *        lock.
-     */
-    bool isWriterHolding;
-
-    /**
-     * @brief A thread identifier of the thread that holds the lock in a
-     *        may-write mode. If no such thread exists, the identifier does not
-     *        represent a thread.
-     */
-    thread::id mayWriterThreadId;
-
 /**-----------------------------------------------------------------------------
  * Private Service Methods:
  * ---------------------------------------------------------------------------*/
@@ -133,36 +226,111 @@ class Read_MayWrite_Write_Lock {
     /**
      * @brief A service method for read condition check.
      * 
+     * @param word A value of the lock word.
+     * 
      * @retval true  If no writer is holding the lock.
      * @retval false If a writer is holding the lock.
      */
-    bool CanReaderAcquireLock() const noexcept;
+    static bool CanReaderAcquireLock(const uint64_t word) noexcept;
 
     /**
      * @brief A service method for may-write condition check.
      * 
+     * @param word A value of the lock word.
+     * 
      * @retval true  If no may-writer and writer are holding the lock.
      * @retval false If a may-writer or a writer is holding the lock.
      */
-    bool CanMayWriterAcquireLock() const noexcept;
+    static bool CanMayWriterAcquireLock(const uint64_t word) noexcept;
 
     /**
      * @brief A service method for write condition check.
      * 
+     * @param word A value of the lock word.
+     * 
      * @retval true  If no one is holding the lock.
      * @retval false If someone is holding the lock.
      */
-    bool CanWriterAcquireLock() const noexcept;
+    static bool CanWriterAcquireLock(const uint64_t word) noexcept;
 
     /**
      * @brief A service method for condition check depending on the operation.
      * 
      * @param operation The acquiring mode for which the check is made.
+     * @param word      A value of the lock word.
      * 
      * @retval true  The lock can be acquired for the specified operation.
      * @retval false The lock can not be acquired for the specified operation.
      */
-    bool CanAcquireLock(const Operation operation) const noexcept;
+    static bool CanAcquireLock(const Operation operation,
+                               const uint64_t word) noexcept;
+
+    /**
+     * @brief A service method that returns what an acquisition adds to the lock
+     *        word (the acquired bits are clear before it).
+     * 
+     * @param operation The acquiring mode of the lock.
+     * @param holder    For a may-write mode, the identifier of an asynchronous
+     *                  holder, or nullptr for the calling thread.
+     * 
+     * @retval uint64_t The addition to the lock word.
+     */
+    static uint64_t Acquisition(const Operation operation,
+                                const void* holder) noexcept;
+
+    /**
+     * @brief A service method that returns the entry of the visible readers
+     *        table that the calling thread uses for this lock, and the value it
+     *        puts there.
+     * 
+     * @param value An output parameter for the value of the thread.
+     * 
+     * @retval atomic<uint64_t>& The entry.
+     */
+    atomic<uint64_t>& VisibleReader(uint64_t& value) const noexcept;
+
+    /**
+     * @brief A service method that acquires the lock in a read mode by
+     *        publishing the calling thread in the visible readers table, if the
+     *        lock is read-biased and no one waits for it.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false Otherwise (the table is not changed).
+     */
+    bool TryBiasedRead() noexcept;
+
+    /**
+     * @brief A service method that releases a read lock that was acquired by
+     *        TryBiasedRead, if the calling thread holds one.
+     * 
+     * @retval true  If the lock was released.
+     * @retval false Otherwise.
+     */
+    bool TryBiasedRelease() noexcept;
+
+    /**
+     * @brief A service method that sets the read bias, if it is enabled and is
+     *        not inhibited. Called by readers that hold the lock, so no writer
+     *        is holding it.
+     */
+    void RestoreReadBias() noexcept;
+
+    /**
+     * @brief A service method that revokes the read bias, and waits for the
+     *        biased readers to leave. Called by writers once they acquired the
+     *        lock.
+     */
+    void RevokeReadBias() noexcept;
+
+    /**
+     * @brief A service method that returns what a may-writer adds to the lock
+     *        word, given its slot.
+     * 
+     * @param slot The slot of the may-writer.
+     * 
+     * @retval uint64_t The addition to the lock word.
+     */
+    static uint64_t MayWriterBits(const uint64_t slot) noexcept;
 
     /**
      * @brief A service method that creates a condition variable for a thread
@@ -177,32 +345,210 @@ class Read_MayWrite_Write_Lock {
 
     /**
      * @brief A service method that checks whether a thread can acquire the lock
-     *        or it should wait for it. In case that a wait is needed, a
-     *        condition variable is created, and pushed to the back of the
-     *        thread queue (if needed).
+     *        or it should wait for it. If it can, the lock is acquired. In case
+     *        that a wait is needed, a condition variable is created, and
+     *        pushed to the back of the thread queue (if needed).
      * 
      * @param operation The acquiring mode of the lock.
      * 
      * @retval true  The thread should wait on the condition variable for the
      *               lock.
-     * @retval false The thread should not wait on the condition variable for
-     *               the lock.
+     * @retval false The thread acquired the lock.
      */
     bool ShouldThreadWait(const Operation operation);
 
+    /**
+     * @brief A service method that spins (with an exponential backoff) while
+     *        the lock is held, for no more than maxSpinRounds rounds, trying
+     *        to acquire it through the lock word, before the thread waits in
+     *        the thread queue. Spinning stops once other threads wait in the
+     *        queue, so it never bypasses them.
+     * 
+     * @param operation The acquiring mode of the lock.
+     * @param isUpgrade If true, the thread holds the lock in a may-write mode,
+     *                  and spins for an upgrade.
+     * 
+     * @retval true  If the lock was acquired (or upgraded).
+     * @retval false Otherwise.
+     */
+    bool Spin(const Operation operation, const bool isUpgrade = false) noexcept;
+
+    /**
+     * @brief A service method that lets a spinning thread wait briefly,
+     *        without giving up the core.
+     */
+    static void CpuRelax() noexcept;
+
     /**
      * @brief A service method that makes a thread wait for its condition
-     *        variable.
+     *        variable, and then acquires the lock.
+     * 
+     * @param operation The acquiring mode of the lock.
+     * 
+     * @retval true  If the thread left the queue, and should try notifying the
+     *               next ones.
+     * @retval false Otherwise.
+     */
+    bool Wait(const Operation operation, unique_lock<mutex>& lock) noexcept;
+
+    /**
+     * @brief A service method that removes the front entry of the thread queue
+     *        (or the calling reader from it), once the thread of the entry
+     *        acquired the lock.
+     * 
+     * @param operation The acquiring mode of the lock.
+     * 
+     * @retval true  If the thread left the queue, and should try notifying the
+     *               next ones.
+     * @retval false Otherwise.
+     */
+    bool LeaveQueue(const Operation operation) noexcept;
+
+    /**
+     * @brief A service method that removes a waiting thread that gave up from
+     *        the thread queue (or from its group of readers).
+     * 
+     * @param conditionPtr The condition variable the thread waited on.
+     */
+    void AbandonQueue(const ConditionPtr& conditionPtr) noexcept;
+
+    /**
+     * @brief A service method that clears HAS_WAITERS if the thread queue is
+     *        empty.
+     */
+    void ClearWaitersIfEmpty() noexcept;
+
+    /**
+     * @brief A service method that acquires the lock through the lock word,
+     *        without the internal mutex, if there are no waiters and the lock
+     *        can be acquired.
+     * 
+     * @param operation The acquiring mode of the lock.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false Otherwise.
+     */
+    bool AcquireUnlessWaiting(const Operation operation) noexcept;
+
+    /**
+     * @brief A service method that acquires the lock if there are no waiters
+     *        and it can be acquired, and otherwise sets HAS_WAITERS, so the
+     *        caller can wait in the queue.
+     * 
+     * @attention It is assumed that the caller holds the internal mutex.
      * 
      * @param operation The acquiring mode of the lock.
+     * @param holder    For a may-write mode, the identifier of an asynchronous
+     *                  holder, or nullptr for the calling thread.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false If HAS_WAITERS was set.
      */
-    void Wait(const Operation operation, unique_lock<mutex>& lock) noexcept;
+    bool AcquireOrMarkWaiting(const Operation operation, const void* holder);
+
+    /**
+     * @brief A service method that marks the lock as acquired by a waiter.
+     * 
+     * @attention It is assumed that the caller holds the internal mutex, that
+     *            HAS_WAITERS is set, and that the lock can be acquired.
+     * 
+     * @param operation The acquiring mode of the lock.
+     * @param holder    For a may-write mode, the identifier of an asynchronous
+     *                  holder, or nullptr for the calling thread.
+     */
+    void Acquire(const Operation operation, const void* holder) noexcept;
+
+    /**
+     * @brief A service method that upgrades the lock of the calling thread
+     *        through the lock word, without the internal mutex, if it is the
+     *        only holder and there are no waiters.
+     * 
+     * @retval true  If the lock was upgraded.
+     * @retval false Otherwise.
+     */
+    bool UpgradeUnlessWaiting() noexcept;
+
+    /**
+     * @brief A service method that gives up the may-write mode of a holder, and
+     *        either acquires the write mode (if it was the only holder) or sets
+     *        HAS_WAITERS, so the holder can wait at the front of the queue.
+     * 
+     * @attention It is assumed that the caller holds the internal mutex.
+     * 
+     * @param slot The slot of the may-writer.
+     * 
+     * @retval true  If the lock was upgraded.
+     * @retval false If HAS_WAITERS was set.
+     */
+    bool UpgradeOrMarkWaiting(const uint64_t slot) noexcept;
+
+    /**
+     * @brief A service method that releases a shared lock in the lock word.
+     * 
+     * @param mayWriterBits What the holder added to the lock word as the
+     *                      may-writer, or 0 if it is a reader.
+     * 
+     * @retval true  If the next waiters should be woken.
+     * @retval false Otherwise.
+     */
+    bool ReleaseShared(const uint64_t mayWriterBits) noexcept;
 
     /**
      * @brief A service method that wakes the next thread(s) in the thread queue
      *        (through their condition variable) if they can acquire the lock.
+     *        Asynchronous waiters at the front of the queue that can acquire
+     *        the lock get it on their behalf, and are moved to a list, so they
+     *        are resumed after the internal mutex was released.
+     * 
+     * @param granted An output list, to which granted asynchronous waiters are
+     *                moved.
+     */
+    void TryNotifyingNext(list<ConditionTuple>& granted) noexcept;
+
+    /**
+     * @brief A service method that tries notifying the next waiters, releases
+     *        the internal mutex, and then resumes the asynchronous waiters that
+     *        were granted the lock.
+     * 
+     * @param lock The held internal mutex.
+     */
+    void NotifyNextAndUnlock(unique_lock<mutex>& lock) noexcept;
+
+    /**
+     * @brief A service method that takes the internal mutex and wakes the next
+     *        waiters. Called after a release that found HAS_WAITERS set.
+     */
+    void NotifyNext() noexcept;
+
+    /**
+     * @brief A service method that acquires the lock if it can be acquired
+     *        without waiting. Otherwise, an asynchronous waiter is pushed to
+     *        the back of the thread queue.
+     * 
+     * @param operation  The acquiring mode of the lock.
+     * @param holder     For a may-write mode, the identifier of the holder.
+     * @param onAcquired The function that resumes the waiter.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false If the waiter was queued.
+     */
+    bool LockOrEnqueue(const Operation operation,
+                       const void* holder,
+                       function<void()>&& onAcquired);
+
+    /**
+     * @brief A service method that acquires the lock, waiting in the thread
+     *        queue for no longer than the given timeout. A thread that gives up
+     *        leaves the queue, so the threads behind it are not delayed.
+     * 
+     * @param operation The acquiring mode of the lock.
+     * @param timeout   The longest time to wait. If not positive, the lock is
+     *                  acquired only if it can be done without waiting.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false If the timeout has passed.
      */
-    void TryNotifyingNext() const noexcept;
+    bool LockFor(const Operation operation, const nanoseconds timeout);
 
 /**-----------------------------------------------------------------------------
  * Public Methods:
@@ -212,8 +558,14 @@ public:
 
     /**
      * @brief The lock's constructor.
+     * 
+     * @param maxSpinRounds The most backoff rounds a thread spins for the lock
+     *                      before it sleeps (see ListOptions::maxSpinRounds).
+     * @param isReadBiased  If true, readers are biased (see
+     *                      ListOptions::isReadBiased).
      */
-    Read_MayWrite_Write_Lock();
+    explicit Read_MayWrite_Write_Lock(const unsigned int maxSpinRounds = 0,
+                                      const bool isReadBiased = false);
 
     /**
      * @brief Locks the lock in a read mode.
@@ -244,12 +596,171 @@ public:
      */
     void UpgradeLock();
 
+    /**
+     * @brief Locks the lock in a read mode, if this is possible without
+     *        waiting (in particular, no thread is waiting for the lock).
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false Otherwise.
+     */
+    bool TryLockRead();
+
+    /**
+     * @brief Locks the lock in a may-write mode, if this is possible without
+     *        waiting. See TryLockRead.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false Otherwise.
+     */
+    bool TryLockMayWrite();
+
+    /**
+     * @brief Locks the lock in a write mode, if this is possible without
+     *        waiting. See TryLockRead.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false Otherwise.
+     */
+    bool TryLockWrite();
+
+    /**
+     * @brief Upgrades the lock from a may-write to a write mode, if there are
+     *        no readers to wait for.
+     * 
+     * @retval true  If the lock was upgraded.
+     * @retval false Otherwise. The lock is still held in a may-write mode.
+     */
+    bool TryUpgradeLock();
+
+    /**
+     * @brief Locks the lock in a read mode, waiting in the queue for no longer
+     *        than the given timeout. A thread that gives up leaves the queue.
+     * 
+     * @param timeout The longest time to wait.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false If the timeout has passed.
+     */
+    bool TryLockReadFor(const nanoseconds timeout);
+
+    /**
+     * @brief Locks the lock in a may-write mode, waiting for no longer than the
+     *        given timeout. See TryLockReadFor.
+     * 
+     * @param timeout The longest time to wait.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false If the timeout has passed.
+     */
+    bool TryLockMayWriteFor(const nanoseconds timeout);
+
+    /**
+     * @brief Locks the lock in a write mode, waiting for no longer than the
+     *        given timeout. See TryLockReadFor.
+     * 
+     * @param timeout The longest time to wait.
+     * 
+     * @retval true  If the lock was acquired.
+     * @retval false If the timeout has passed.
+     */
+    bool TryLockWriteFor(const nanoseconds timeout);
+
+    /**
+     * @brief Upgrades the lock from a may-write to a write mode, waiting for
+     *        the readers to leave for no longer than the given timeout. Like
+     *        UpgradeLock, the upgrade has a priority over any other waiting
+     *        threads.
+     * 
+     * @param timeout The longest time to wait.
+     * 
+     * @retval true  If the lock was upgraded.
+     * @retval false If the timeout has passed. The lock is still held in a
+     *               may-write mode.
+     */
+    bool TryUpgradeLockFor(const nanoseconds timeout);
+
+    /**
+     * @brief Downgrades the lock from a write to a may-write mode, atomically,
+     *        so no other writer or may-writer can acquire it in between.
+     *        Waiting readers at the front of the queue are woken.
+     */
+    void DowngradeToMayWrite() noexcept;
+
+    /**
+     * @brief Downgrades the lock from a may-write to a read mode, atomically.
+     *        A may-writer waiting at the front of the queue is woken.
+     */
+    void DowngradeToRead() noexcept;
+
     /**
      * @brief Releases the lock that was acquired in shared (read/may-write)
      *        mode.
      */
     void ReleaseSharedLock() noexcept;
 
+    /**
+     * @brief Locks the lock in a read mode, if this is possible without
+     *        waiting. Otherwise, the caller is queued without blocking, and the
+     *        given function is called once the lock was acquired on its behalf
+     *        (by the thread that released it, after it released the internal
+     *        mutex). This is the building block of asynchronous waiters, such
+     *        as coroutines.
+     * 
+     * @param onAcquired The function that resumes the caller.
+     * 
+     * @retval true  If the lock was acquired (onAcquired is not called).
+     * @retval false If the caller was queued.
+     */
+    bool LockReadOrEnqueue(function<void()> onAcquired);
+
+    /**
+     * @brief Locks the lock in a may-write mode, without blocking. See
+     *        LockReadOrEnqueue.
+     * 
+     * @param holder     An identifier of the holder, to be passed to
+     *                   UpgradeLockOrEnqueue and ReleaseSharedLock. It must
+     *                   not be the address of a thread-local object.
+     * @param onAcquired The function that resumes the caller.
+     * 
+     * @retval true  If the lock was acquired (onAcquired is not called).
+     * @retval false If the caller was queued.
+     */
+    bool LockMayWriteOrEnqueue(const void* holder,
+                               function<void()> onAcquired);
+
+    /**
+     * @brief Locks the lock in a write mode, without blocking. See
+     *        LockReadOrEnqueue.
+     * 
+     * @param onAcquired The function that resumes the caller.
+     * 
+     * @retval true  If the lock was acquired (onAcquired is not called).
+     * @retval false If the caller was queued.
+     */
+    bool LockWriteOrEnqueue(function<void()> onAcquired);
+
+    /**
+     * @brief Upgrades the lock from a may-write to a write mode, without
+     *        blocking. Like UpgradeLock, the upgrade has a priority over any
+     *        other waiting threads. See LockReadOrEnqueue.
+     * 
+     * @param holder     The identifier the lock was acquired with.
+     * @param onAcquired The function that resumes the caller.
+     * 
+     * @retval true  If the lock was upgraded (onAcquired is not called).
+     * @retval false If the caller was queued.
+     */
+    bool UpgradeLockOrEnqueue(const void* holder, function<void()> onAcquired);
+
+    /**
+     * @brief Releases the lock that was acquired in shared (read/may-write)
+     *        mode by an asynchronous holder.
+     * 
+     * @param holder The identifier the lock was acquired with (for a read
+     *               mode, any identifier of the holder).
+     */
+    void ReleaseSharedLock(const void* holder) noexcept;
+
     /**
      * @brief Releases the lock that was acquired in exclusive (write) mode.
      */
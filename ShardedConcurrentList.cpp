@@ -0,0 +1,297 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: ShardedConcurrentList.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ShardedConcurrentList.h"
+#include "ThreadSlot.h"
+#include <algorithm>
+#include <limits>
+#include <cassert>
+
+using std::make_unique;
+using std::make_shared;
+using std::upper_bound;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+typedef ShardedConcurrentList Sharded;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * ShardedConcurrentList::TableReader:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+Sharded::TableReader::TableReader(
+                        const ShardedConcurrentList& in_list) noexcept :
+        list(in_list),
+        stripe(in_list.readersStripes
+                   [in_list.readersEpoch.load() % READERS_COUNTERS_NUMBER]
+                   [ThreadSlot::Index() % READERS_STRIPES_NUMBER]) {
+    // Sequentially consistent, so either ReclaimTables sees the reader, or the
+    // reader sees the table that was current when ReclaimTables ran.
+    stripe.readersNumber.fetch_add(1);
+}
+
+Sharded::TableReader::~TableReader() {
+    stripe.readersNumber.fetch_sub(1, memory_order_release);
+}
+
+const Sharded::RoutingTable& Sharded::TableReader::Table() const noexcept {
+    return *list.routingTable.load();
+}
+
+/*******************************************************************************
+ * ShardedConcurrentList:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+Sharded::List& Sharded::Route(const RoutingTable& table,
+                              const int key) noexcept {
+    // The first lower bound is the lowest int, so the result is never begin().
+    const vector<int>& lowerBounds(table.lowerBounds);
+    const auto shard(upper_bound(lowerBounds.begin(), lowerBounds.end(), key));
+    return *table.shards[static_cast<size_t>(shard - lowerBounds.begin()) - 1];
+}
+
+ListOptions Sharded::ShardOptions(const int lowestKey,
+                                  const int highestKey) const noexcept {
+    ListOptions shardOptions(options);
+    shardOptions.lowestKey = lowestKey;
+    shardOptions.highestKey = highestKey;
+    return shardOptions;
+}
+
+void Sharded::Publish(unique_ptr<const RoutingTable> table) {
+    routingTable.store(table.get());
+    routingTables.push_back(std::move(table));
+}
+
+void Sharded::ReclaimTables() noexcept {
+    const unsigned int epoch(readersEpoch.load(memory_order_relaxed));
+    for(const ReadersStripe& stripe :
+                readersStripes[(epoch + 1) % READERS_COUNTERS_NUMBER]) {
+        if(stripe.readersNumber.load() != 0) return;
+    }
+
+    const auto retiredTables(static_cast<ptrdiff_t>(retiredTablesNumber));
+    routingTables.erase(routingTables.begin(),
+                        routingTables.begin() + retiredTables);
+    retiredTablesNumber = routingTables.size() - 1;
+    readersEpoch.store(epoch + 1);
+}
+
+/* public:
+ *********/
+
+Sharded::ShardedConcurrentList(const vector<int>& boundaries,
+                               const ListOptions& in_options/* = {}*/) :
+                                                        options(in_options),
+                                                        routingTable(nullptr),
+                                                        readersEpoch(0),
+                                                        retiredTablesNumber(0) {
+    for(ReadersStripe (&counter)[READERS_STRIPES_NUMBER] : readersStripes) {
+        for(ReadersStripe& stripe : counter) {
+            stripe.readersNumber.store(0, memory_order_relaxed);
+        }
+    }
+
+    unique_ptr<RoutingTable> table(make_unique<RoutingTable>());
+    table->lowerBounds.reserve(boundaries.size() + 1);
+    table->lowerBounds.push_back(numeric_limits<int>::min());
+    for(const int boundary : boundaries) {
+        assert(boundary > table->lowerBounds.back());
+        table->lowerBounds.push_back(boundary);
+    }
+
+    table->shards.reserve(table->lowerBounds.size());
+    for(size_t i = 0; i < table->lowerBounds.size(); ++i) {
+        const int highestKey(i + 1 < table->lowerBounds.size() ?
+                                 table->lowerBounds[i + 1] - 1 :
+                                 numeric_limits<int>::max());
+        table->shards.push_back(make_shared<List>(
+                          ShardOptions(table->lowerBounds[i], highestKey)));
+    }
+
+    scoped_lock<mutex> lock(rebalanceMutex);
+    Publish(std::move(table));
+}
+
+bool Sharded::InsertHead(const int key, const char data) {
+    return Routed(key, [key, data](List& shard) {
+        return shard.InsertHead(key, data);
+    });
+}
+
+bool Sharded::InsertTail(const int key, const char data) {
+    return Routed(key, [key, data](List& shard) {
+        return shard.InsertTail(key, data);
+    });
+}
+
+bool Sharded::Delete(const int key) noexcept {
+    return Routed(key, [key](List& shard) {
+        return shard.Delete(key);
+    });
+}
+
+bool Sharded::Search(const int key, char* data) const noexcept {
+    return Routed(key, [key, data](List& shard) {
+        return shard.Search(key, data);
+    });
+}
+
+bool Sharded::Update(const int key, const char data) noexcept {
+    return Routed(key, [key, data](List& shard) {
+        return shard.Update(key, data);
+    });
+}
+
+bool Sharded::FetchAdd(const int key,
+                       const char delta,
+                       char* previous/* = nullptr*/) noexcept {
+    return Routed(key, [key, delta, previous](List& shard) {
+        return shard.FetchAdd(key, delta, previous);
+    });
+}
+
+size_t Sharded::Size() const noexcept {
+    const TableReader reader(*this);
+    size_t size(0);
+    for(const shared_ptr<List>& shard : reader.Table().shards) {
+        size += shard->Size();
+    }
+    return size;
+}
+
+size_t Sharded::ApproximateSize() const noexcept {
+    const TableReader reader(*this);
+    size_t size(0);
+    for(const shared_ptr<List>& shard : reader.Table().shards) {
+        size += shard->ApproximateSize();
+    }
+    return size;
+}
+
+size_t Sharded::ShardsNumber() const noexcept {
+    const TableReader reader(*this);
+    return reader.Table().shards.size();
+}
+
+size_t Sharded::ShardSize(const size_t index) const noexcept {
+    const TableReader reader(*this);
+    const RoutingTable& table(reader.Table());
+    return index < table.shards.size() ? table.shards[index]->Size() : 0;
+}
+
+bool Sharded::SplitShard(const size_t index) {
+    scoped_lock<mutex> lock(rebalanceMutex);
+
+    const RoutingTable& table(*routingTable.load(memory_order_acquire));
+    if(index >= table.shards.size()) return false;
+
+    List& shard(*table.shards[index]);
+    const size_t size(shard.Size());
+    int median(0);
+    if(size < 2 || !shard.Select(size / 2, &median) || \
+       median <= table.lowerBounds[index]) {
+        return false;
+    }
+
+    const shared_ptr<List> newShard(make_shared<List>(
+                                  ShardOptions(median, shard.tail->key)));
+    unique_ptr<RoutingTable> newTable(make_unique<RoutingTable>(table));
+    const auto offset(static_cast<ptrdiff_t>(index) + 1);
+    newTable->lowerBounds.insert(newTable->lowerBounds.begin() + offset,
+                                 median);
+    newTable->shards.insert(newTable->shards.begin() + offset, newShard);
+
+    shard.SplitInto(median, *newShard, [this, &newTable]() {
+        Publish(std::move(newTable));
+    });
+
+    ReclaimTables();
+    return true;
+}
+
+bool Sharded::MergeShards(const size_t index) {
+    scoped_lock<mutex> lock(rebalanceMutex);
+
+    const RoutingTable& table(*routingTable.load(memory_order_acquire));
+    if(index + 1 >= table.shards.size()) return false;
+
+    unique_ptr<RoutingTable> newTable(make_unique<RoutingTable>(table));
+    const auto offset(static_cast<ptrdiff_t>(index) + 1);
+    newTable->lowerBounds.erase(newTable->lowerBounds.begin() + offset);
+    newTable->shards.erase(newTable->shards.begin() + offset);
+
+    // The shards' ranges are ordered, so the append never fails.
+    const bool isMerged(table.shards[index]->AppendFrom(
+                                               *table.shards[index + 1],
+                                               /*shouldRetire = */true,
+                                               [this, &newTable]() {
+        Publish(std::move(newTable));
+    }));
+
+    // The retired shard is no longer touched, and may be destroyed with the
+    // old table.
+    ReclaimTables();
+    return isMerged;
+}
+
+size_t Sharded::Rebalance(const size_t maxShardSize,
+                          const size_t minShardSize) {
+    size_t changes(0);
+
+    for(size_t i = 0; i < ShardsNumber(); ) {
+        if(ShardSize(i) > maxShardSize && SplitShard(i)) {
+            ++changes; // The lower half stays at index i, and is checked again.
+        } else {
+            ++i;
+        }
+    }
+
+    for(size_t i = 0; i + 1 < ShardsNumber(); ) {
+        if(ShardSize(i) + ShardSize(i + 1) < minShardSize && MergeShards(i)) {
+            ++changes; // The merged shard stays at index i, and is checked
+                       // again with the next one.
+        } else {
+            ++i;
+        }
+    }
+
+    return changes;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
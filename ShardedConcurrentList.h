@@ -0,0 +1,410 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: ShardedConcurrentList.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef SHARDED_CONCURRENT_LIST_H_
+#define SHARDED_CONCURRENT_LIST_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ConcurrentDoublyLinkedList.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::vector;
+using std::shared_ptr;
+using std::mutex;
+using std::scoped_lock;
+using std::memory_order_acquire;
+using std::size_t;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A map of keys to data, partitioned by key ranges into shards, each
+ *        backed by its own concurrent doubly-linked list.
+ * 
+ * Behavior:
+ *  - Every operation is routed by its key to a single shard, by a binary
+ *    search over the shards' lower bounds. Routing tables are immutable, and
+ *    the current one is published through an atomic pointer, so routing takes
+ *    no locks, and writes only to a readers counter stripe of the thread.
+ *  - Operations on keys of different shards never touch the same node lock,
+ *    including the head lock, and each shard's list is shorter than a single
+ *    list holding all the keys.
+ *  - The order of the keys is kept within each shard, and between the shards.
+ *  - Shards can be split and merged online (see SplitShard, MergeShards and
+ *    Rebalance). Each shard's list accepts only the keys of its range, so an
+ *    operation that was routed by an old table fails, and is retried with the
+ *    new table, which is published before the shards' boundary nodes are
+ *    released.
+ *  - A table that is no longer current is reclaimed (with the shards that no
+ *    other table holds) by a later split or merge, once every thread that
+ *    started routing before it was replaced is done. Readers are counted by
+ *    epochs, so readers that start later do not hold the reclamation back.
+ */
+class ShardedConcurrentList {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    typedef ConcurrentDoublyLinkedList List;
+
+    /**
+     * @brief The number of stripes of each readers counter.
+     */
+    static constexpr unsigned int READERS_STRIPES_NUMBER = 64;
+
+    /**
+     * @brief The number of readers counters. A reader is counted in the
+     *        counter of the epoch's parity.
+     */
+    static constexpr unsigned int READERS_COUNTERS_NUMBER = 2;
+
+    /**
+     * @brief An immutable partition of the keys into shards.
+     */
+    struct RoutingTable {
+
+        /**
+         * @brief The lowest key of each shard, in increasing order. The first
+         *        one is always the lowest int, so every key has a shard.
+         */
+        vector<int> lowerBounds;
+
+        /**
+         * @brief The shards. The shard at index i holds the keys in the range
+         *        [lowerBounds[i], lowerBounds[i + 1]). Shards are shared with
+         *        older and newer tables.
+         */
+        vector<shared_ptr<List>> shards;
+    };
+
+    /**
+     * @brief A single stripe of the readers counter, padded to a cache line.
+     */
+    struct alignas(CACHE_LINE_SIZE) ReadersStripe {
+
+        /**
+         * @brief The number of threads of the stripe that read routing tables.
+         */
+        atomic<long> readersNumber;
+    };
+
+    /**
+     * @brief Marks the calling thread as a reader of routing tables while it
+     *        lives, so no table it loads is reclaimed before it is destroyed.
+     *        A thread counts itself in the counter of the current epoch, in
+     *        the stripe chosen by its thread slot.
+     */
+    class TableReader {
+
+        /**
+         * @brief The sharded list whose tables are read.
+         */
+        const ShardedConcurrentList& list;
+
+        /**
+         * @brief The stripe the thread is counted in.
+         */
+        ReadersStripe& stripe;
+
+    public:
+
+        /**
+         * @brief Counts the calling thread as a reader of the list's tables.
+         * 
+         * @param in_list The sharded list.
+         */
+        explicit TableReader(const ShardedConcurrentList& in_list) noexcept;
+
+        /**
+         * @brief Stops counting the calling thread as a reader.
+         */
+        ~TableReader();
+
+        TableReader(const TableReader&) = delete;
+        TableReader& operator=(const TableReader&) = delete;
+
+        /**
+         * @brief Returns the current routing table, which is not reclaimed
+         *        while this reader lives.
+         * 
+         * @retval const RoutingTable& The current routing table.
+         */
+        const RoutingTable& Table() const noexcept;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The configuration of every shard's list (except for its key
+     *        range).
+     */
+    const ListOptions options;
+
+    /**
+     * @brief The current routing table.
+     */
+    atomic<const RoutingTable*> routingTable;
+
+    /**
+     * @brief The routing tables that were not reclaimed yet. The last one is
+     *        the current table, and the others (and the shards only they hold)
+     *        are kept while threads may still route by them.
+     */
+    vector<unique_ptr<const RoutingTable>> routingTables;
+
+    /**
+     * @brief The readers counters, which count the threads that read routing
+     *        tables (see TableReader).
+     */
+    mutable ReadersStripe readersStripes[READERS_COUNTERS_NUMBER]
+                                        [READERS_STRIPES_NUMBER];
+
+    /**
+     * @brief The epoch of the readers, which chooses the counter new readers
+     *        are counted in. It is advanced by ReclaimTables.
+     */
+    atomic<unsigned int> readersEpoch;
+
+    /**
+     * @brief The number of tables at the start of routingTables that were no
+     *        longer current when readersEpoch was last advanced.
+     */
+    size_t retiredTablesNumber;
+
+    /**
+     * @brief Serializes splits and merges, and protects routingTables.
+     */
+    mutex rebalanceMutex;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Finds the shard that holds the given key in a routing table.
+     * 
+     * @param table The routing table.
+     * @param key   The key to route.
+     * 
+     * @retval List& The shard that holds the key.
+     */
+    static List& Route(const RoutingTable& table, const int key) noexcept;
+
+    /**
+     * @brief Runs an operation on the shard that holds the key. A failure may
+     *        be caused by a concurrent split or merge that moved the key to
+     *        another shard, and it always publishes a new routing table first.
+     *        In this case, the operation is retried with the new table.
+     * 
+     * @attention The operation must have no effect when it fails.
+     * 
+     * @param key       The key of the operation.
+     * @param operation A callable that gets the shard, and returns whether the
+     *                  operation succeeded.
+     * 
+     * @retval true  If the operation succeeded.
+     * @retval false If the operation failed on the right shard.
+     */
+    template<typename Operation>
+    bool Routed(const int key, const Operation& operation) const;
+
+    /**
+     * @brief Returns the configuration of a shard's list with the given range.
+     * 
+     * @param lowestKey  The lowest key of the shard.
+     * @param highestKey The highest key of the shard.
+     * 
+     * @retval ListOptions The configuration of the shard's list.
+     */
+    ListOptions ShardOptions(const int lowestKey,
+                             const int highestKey) const noexcept;
+
+    /**
+     * @brief Makes a table the current routing table.
+     * 
+     * @attention It is assumed that the thread executing this method holds
+     *            rebalanceMutex.
+     * 
+     * @param table The new routing table.
+     */
+    void Publish(unique_ptr<const RoutingTable> table);
+
+    /**
+     * @brief If no reader of the previous epoch is left, reclaims the tables
+     *        that were retired before the epoch was advanced, and advances it.
+     *        Only readers that loaded the epoch before it was advanced could
+     *        load these tables, and they are all counted in the previous
+     *        epoch's counter.
+     * 
+     * @attention It is assumed that the thread executing this method holds
+     *            rebalanceMutex, and uses no table but the current one.
+     */
+    void ReclaimTables() noexcept;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The sharded list's constructor.
+     * 
+     * @attention It is assumed that the boundaries are strictly increasing.
+     * 
+     * @param boundaries The keys at which a new shard starts. n boundaries
+     *                   make n + 1 shards.
+     * @param options    The configuration of every shard's list.
+     */
+    explicit ShardedConcurrentList(const vector<int>& boundaries,
+                                   const ListOptions& options = {});
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::InsertHead.
+     */
+    bool InsertHead(const int key, const char data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::InsertTail.
+     */
+    bool InsertTail(const int key, const char data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Delete.
+     */
+    bool Delete(const int key) noexcept;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Search.
+     */
+    bool Search(const int key, char* data) const noexcept;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Update.
+     */
+    bool Update(const int key, const char data) noexcept;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::FetchAdd.
+     */
+    bool FetchAdd(const int key,
+                  const char delta,
+                  char* previous = nullptr) noexcept;
+
+    /**
+     * @brief Returns the number of keys in all the shards.
+     *        See ConcurrentDoublyLinkedList::Size.
+     * 
+     * @retval size_t The number of keys.
+     */
+    size_t Size() const noexcept;
+
+    /**
+     * @brief Returns an approximation of the number of keys in all the shards.
+     *        See ConcurrentDoublyLinkedList::ApproximateSize. The error of
+     *        each shard adds up.
+     * 
+     * @retval size_t The approximate number of keys.
+     */
+    size_t ApproximateSize() const noexcept;
+
+    /**
+     * @brief Returns the number of shards.
+     * 
+     * @retval size_t The number of shards.
+     */
+    size_t ShardsNumber() const noexcept;
+
+    /**
+     * @brief Returns the number of keys in a shard.
+     * 
+     * @param index The index of the shard.
+     * 
+     * @retval size_t The number of keys in the shard, or 0 if there is no such
+     *                shard.
+     */
+    size_t ShardSize(const size_t index) const noexcept;
+
+    /**
+     * @brief Splits a shard at its median key, while operations on it go on.
+     *        See ConcurrentDoublyLinkedList::SplitInto.
+     * 
+     * @param index The index of the shard.
+     * 
+     * @retval true  If the shard was split.
+     * @retval false If there is no such shard, or it has less than two keys.
+     */
+    bool SplitShard(const size_t index);
+
+    /**
+     * @brief Merges a shard with the next one, while operations on them go on.
+     *        See ConcurrentDoublyLinkedList::AppendFrom.
+     * 
+     * @param index The index of the first shard.
+     * 
+     * @retval true  If the shards were merged.
+     * @retval false If there are no such shards.
+     */
+    bool MergeShards(const size_t index);
+
+    /**
+     * @brief Splits every shard that holds more than maxShardSize keys, and
+     *        then merges every two adjacent shards that hold less than
+     *        minShardSize keys together.
+     * 
+     * @attention It is assumed that minShardSize is not larger than
+     *            maxShardSize.
+     * 
+     * @param maxShardSize The size above which a shard is split.
+     * @param minShardSize The size below which two shards are merged.
+     * 
+     * @retval size_t The number of splits and merges made.
+     */
+    size_t Rebalance(const size_t maxShardSize, const size_t minShardSize);
+};
+
+/**=============================================================================
+ * Implementation:
+ * ===========================================================================*/
+
+template<typename Operation>
+bool ShardedConcurrentList::Routed(const int key,
+                                   const Operation& operation) const {
+    const TableReader reader(*this);
+    while(true) {
+        const RoutingTable* const table(&reader.Table());
+        if(operation(Route(*table, key))) return true;
+        if(&reader.Table() == table) return false;
+    }
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* SHARDED_CONCURRENT_LIST_H_ */
\ No newline at end of file
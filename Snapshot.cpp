@@ -0,0 +1,130 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: Snapshot.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "Snapshot.h"
+#include <fstream>
+#ifdef LIST_HAS_FILE_SYNC
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using std::ifstream;
+using std::ios;
+using std::streamoff;
+using std::streamsize;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * Snapshot:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+uint64_t Snapshot::Checksum(const void* const bytes,
+                            const size_t size,
+                            uint64_t checksum/* = CHECKSUM_SEED*/) noexcept {
+    const unsigned char* const begin(static_cast<const unsigned char*>(bytes));
+    for(size_t i = 0; i < size; ++i) {
+        checksum ^= begin[i];
+        checksum *= 0x100000001b3ULL; // The FNV prime.
+    }
+    return checksum;
+}
+
+size_t Snapshot::FileSize(const size_t count) noexcept {
+    return sizeof(Header) + count * (sizeof(int) + sizeof(char));
+}
+
+bool Snapshot::IsValid(const Header& header, const size_t fileSize) noexcept {
+    // The count is checked against the file before it is multiplied, so a
+    // corrupted one cannot overflow.
+    return header.magic == MAGIC && header.version == VERSION && \
+           header.reserved == 0 && fileSize >= sizeof(Header) && \
+           header.count <= (fileSize - sizeof(Header)) / \
+                           (sizeof(int) + sizeof(char)) && \
+           FileSize(static_cast<size_t>(header.count)) == fileSize;
+}
+
+bool Snapshot::Read(const string& path, vector<int>* keys, vector<char>* data) {
+    if(keys == nullptr || data == nullptr) return false;
+
+    ifstream file(path, ios::binary | ios::ate);
+    if(!file) return false;
+    const streamoff fileSize(file.tellg());
+    file.seekg(0);
+
+    Header header{};
+    if(fileSize < 0 || \
+       !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || \
+       !IsValid(header, static_cast<size_t>(fileSize))) {
+        return false;
+    }
+
+    const size_t count(static_cast<size_t>(header.count));
+    keys->resize(count);
+    data->resize(count);
+    if(!file.read(reinterpret_cast<char*>(keys->data()),
+                  static_cast<streamsize>(count * sizeof(int))) || \
+       !file.read(data->data(), static_cast<streamsize>(count))) {
+        return false;
+    }
+
+    if(Checksum(data->data(),
+                count,
+                Checksum(keys->data(), count * sizeof(int))) != \
+       header.checksum) {
+        return false;
+    }
+
+    for(size_t i = 1; i < count; ++i) {
+        if((*keys)[i] <= (*keys)[i - 1]) return false;
+    }
+
+    return true;
+}
+
+bool Snapshot::Sync(const string& path) noexcept {
+#ifdef LIST_HAS_FILE_SYNC
+    const int file(open(path.c_str(), O_RDONLY));
+    if(file < 0) return false;
+
+    const bool result(fsync(file) == 0);
+    close(file);
+    return result;
+#else
+    static_cast<void>(path);
+    return true;
+#endif
+}
+
+bool Snapshot::SyncDirectory(const string& path) {
+    const size_t slash(path.rfind('/'));
+    return Sync(slash == string::npos ? "." : path.substr(0, slash + 1));
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
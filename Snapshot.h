@@ -0,0 +1,202 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: Snapshot.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+/**=============================================================================
+ * Definitions:
+ * ===========================================================================*/
+
+/**
+ * @brief Defined when files can be flushed to the disk (POSIX). Otherwise,
+ *        snapshots are saved without flushing, so they survive a crash of the
+ *        process but not of the system, and write-ahead logs cannot be opened
+ *        (see WriteAheadLog).
+ */
+#if __has_include(<unistd.h>) && __has_include(<fcntl.h>)
+#define LIST_HAS_FILE_SYNC
+#endif
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::string;
+using std::vector;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief The binary snapshot file format of a list (see
+ *        ConcurrentDoublyLinkedList::SaveSnapshot).
+ * 
+ * Behavior:
+ *  - A file is a Header, followed by the keys of the entries in increasing
+ *    order (4 bytes each), followed by their data (1 byte each), so the keys
+ *    can be searched in place.
+ *  - The checksum is a 64-bit FNV-1a hash of the keys and then the data.
+ *  - Numbers are in the byte order of the machine that saved the file. A file
+ *    of the other byte order is rejected by its magic number.
+ */
+class Snapshot {
+
+/**-----------------------------------------------------------------------------
+ * Public Definitions:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    static_assert(sizeof(int) == sizeof(uint32_t), "Keys are saved in 4 bytes");
+
+    /**
+     * @brief The header at the beginning of a snapshot file.
+     */
+    struct Header {
+
+        /**
+         * @brief Identifies the file format (MAGIC).
+         */
+        uint64_t magic;
+
+        /**
+         * @brief The version of the file format (VERSION).
+         */
+        uint32_t version;
+
+        /**
+         * @brief Must be 0.
+         */
+        uint32_t reserved;
+
+        /**
+         * @brief The number of entries.
+         */
+        uint64_t count;
+
+        /**
+         * @brief The checksum of the keys and the data.
+         */
+        uint64_t checksum;
+    };
+
+    /**
+     * @brief The magic number of snapshot files ("CDLLSNAP").
+     */
+    static constexpr uint64_t MAGIC = 0x50414e534c4c4443ULL;
+
+    /**
+     * @brief The current version of the file format.
+     */
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief The checksum of no bytes (the FNV-1a offset basis).
+     */
+    static constexpr uint64_t CHECKSUM_SEED = 0xcbf29ce484222325ULL;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Extends a checksum over more bytes.
+     * 
+     * @param bytes    The bytes.
+     * @param size     The number of bytes.
+     * @param checksum The checksum of the preceding bytes.
+     * 
+     * @retval uint64_t The checksum of all the bytes.
+     */
+    static uint64_t Checksum(const void* const bytes,
+                             const size_t size,
+                             uint64_t checksum = CHECKSUM_SEED) noexcept;
+
+    /**
+     * @brief Returns the size of a snapshot file of some entries.
+     * 
+     * @param count The number of entries.
+     * 
+     * @retval size_t The size, in bytes.
+     */
+    static size_t FileSize(const size_t count) noexcept;
+
+    /**
+     * @brief Checks that a header is of the current format, and matches the
+     *        size of its file. The checksum is not checked.
+     * 
+     * @param header   The header.
+     * @param fileSize The size of the file, in bytes.
+     * 
+     * @retval true  If the header is valid.
+     * @retval false Otherwise.
+     */
+    static bool IsValid(const Header& header, const size_t fileSize) noexcept;
+
+    /**
+     * @brief Reads a whole snapshot file, and checks its header, its checksum,
+     *        and the order of its keys.
+     * 
+     * @param path The path of the file.
+     * @param keys An output parameter, to which the keys should be written.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the file was read, and it is valid.
+     * @retval false Otherwise (the outputs are unspecified).
+     */
+    static bool Read(const string& path, vector<int>* keys, vector<char>* data);
+
+    /**
+     * @brief Flushes a file, or a directory (so that the names of its files
+     *        are flushed), to the disk.
+     * 
+     * @param path The path of the file or the directory.
+     * 
+     * @retval true  If it was flushed, or if files cannot be flushed on this
+     *               system (see LIST_HAS_FILE_SYNC).
+     * @retval false Otherwise.
+     */
+    static bool Sync(const string& path) noexcept;
+
+    /**
+     * @brief Flushes the directory of a file to the disk, so that a new name
+     *        of the file (by creation or by rename) is durable.
+     * 
+     * @param path The path of the file.
+     * 
+     * @retval true  If the directory was flushed (see Sync).
+     * @retval false Otherwise.
+     */
+    static bool SyncDirectory(const string& path);
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* SNAPSHOT_H_ */
\ No newline at end of file
@@ -0,0 +1,209 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: SnapshotView.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "SnapshotView.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#ifdef LIST_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using std::lower_bound;
+using std::memcpy;
+using std::ifstream;
+using std::ios;
+using std::streamoff;
+using std::streamsize;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * SnapshotView:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+size_t SnapshotView::LowerBound(const int key) const noexcept {
+    const int* const bound(lower_bound(keyArray, keyArray + count, key));
+    return static_cast<size_t>(bound - keyArray);
+}
+
+bool SnapshotView::Attach(const bool shouldVerify) noexcept {
+    Snapshot::Header header{};
+    if(contentsSize < sizeof(header)) return false;
+    memcpy(&header, contents, sizeof(header));
+    if(!Snapshot::IsValid(header, contentsSize)) return false;
+
+    count = static_cast<size_t>(header.count);
+    // The header is a multiple of 4 bytes, and the contents are aligned to a
+    // page (or by new), so the keys are aligned.
+    keyArray = reinterpret_cast<const int*>(contents + sizeof(header));
+    dataArray = contents + sizeof(header) + count * sizeof(int);
+
+    if(shouldVerify) {
+        const uint64_t keysChecksum(Snapshot::Checksum(keyArray,
+                                                       count * sizeof(int)));
+        if(Snapshot::Checksum(dataArray, count, keysChecksum) != \
+           header.checksum) {
+            return false;
+        }
+        for(size_t i = 1; i < count; ++i) {
+            if(keyArray[i] <= keyArray[i - 1]) return false;
+        }
+    }
+
+    return true;
+}
+
+void SnapshotView::Close() noexcept {
+#ifdef LIST_HAS_MMAP
+    if(contents != nullptr && buffer.empty()) {
+        munmap(const_cast<char*>(contents), contentsSize);
+    }
+#endif
+    contents = nullptr;
+    contentsSize = 0;
+    buffer.clear();
+    keyArray = nullptr;
+    dataArray = nullptr;
+    count = 0;
+}
+
+/* public:
+ *********/
+
+SnapshotView::SnapshotView(const string& path,
+                           const bool shouldVerify/* = false*/) :
+                                                        contents(nullptr),
+                                                        contentsSize(0),
+                                                        keyArray(nullptr),
+                                                        dataArray(nullptr),
+                                                        count(0) {
+#ifdef LIST_HAS_MMAP
+    const int file(open(path.c_str(), O_RDONLY));
+    if(file < 0) return;
+
+    struct stat status{};
+    if(fstat(file, &status) == 0 && \
+       static_cast<size_t>(status.st_size) >= sizeof(Snapshot::Header)) {
+        // Shared, so the pages are those of the page cache.
+        void* const mapping(mmap(nullptr,
+                                 static_cast<size_t>(status.st_size),
+                                 PROT_READ,
+                                 MAP_SHARED,
+                                 file,
+                                 0));
+        if(mapping != MAP_FAILED) {
+            contents = static_cast<const char*>(mapping);
+            contentsSize = static_cast<size_t>(status.st_size);
+        }
+    }
+    close(file); // The mapping keeps the file.
+#else
+    ifstream file(path, ios::binary | ios::ate);
+    const streamoff fileSize(file.tellg());
+    if(!file || fileSize < 0) return;
+    file.seekg(0);
+
+    buffer.resize(static_cast<size_t>(fileSize));
+    if(!file.read(buffer.data(), static_cast<streamsize>(fileSize))) {
+        buffer.clear();
+        return;
+    }
+    contents = buffer.data();
+    contentsSize = buffer.size();
+#endif
+
+    if(!Attach(shouldVerify)) Close();
+}
+
+SnapshotView::~SnapshotView() noexcept {
+    Close();
+}
+
+bool SnapshotView::IsOpen() const noexcept {
+    return contents != nullptr;
+}
+
+bool SnapshotView::Search(const int key, char* data) const noexcept {
+    if(data == nullptr) return false;
+
+    const size_t index(LowerBound(key));
+    if(index == count || keyArray[index] != key) return false;
+
+    *data = dataArray[index];
+    return true;
+}
+
+void SnapshotView::Scan(
+                const int key,
+                const function<bool(const int, const char)>& visitor) const {
+    for(size_t i = LowerBound(key); i < count; ++i) {
+        if(!visitor(keyArray[i], dataArray[i])) break;
+    }
+}
+
+bool SnapshotView::PeekMin(int* key, char* data) const noexcept {
+    if(key == nullptr || data == nullptr || count == 0) return false;
+
+    *key = keyArray[0];
+    *data = dataArray[0];
+    return true;
+}
+
+bool SnapshotView::PeekMax(int* key, char* data) const noexcept {
+    if(key == nullptr || data == nullptr || count == 0) return false;
+
+    *key = keyArray[count - 1];
+    *data = dataArray[count - 1];
+    return true;
+}
+
+size_t SnapshotView::Size() const noexcept {
+    return count;
+}
+
+size_t SnapshotView::ApproximateSize() const noexcept {
+    return count;
+}
+
+size_t SnapshotView::Rank(const int key) const noexcept {
+    return LowerBound(key);
+}
+
+bool SnapshotView::Select(const size_t index, int* key) const noexcept {
+    if(key == nullptr || index >= count) return false;
+
+    *key = keyArray[index];
+    return true;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,253 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: SnapshotView.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef SNAPSHOT_VIEW_H_
+#define SNAPSHOT_VIEW_H_
+
+/**=============================================================================
+ * Definitions:
+ * ===========================================================================*/
+
+/**
+ * @brief Defined when snapshot files can be memory-mapped (POSIX). Otherwise,
+ *        a view reads its whole file into memory.
+ */
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define LIST_HAS_MMAP
+#endif
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "Snapshot.h"
+#include <functional>
+
+using std::function;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A read-only map of keys to data, served directly from a snapshot file
+ *        (see ConcurrentDoublyLinkedList::SaveSnapshot), with the query API of
+ *        ConcurrentDoublyLinkedList.
+ * 
+ * Behavior:
+ *  - The file is memory-mapped, and its sorted array of keys is searched in
+ *    place by binary search, so nothing is deserialized, and processes that
+ *    view the same file share its pages in the page cache.
+ *  - Queries take O(log n) and no locks, so any number of threads may run
+ *    them concurrently.
+ *  - A view that failed to open is empty.
+ * 
+ * @attention The file must not be modified while it is viewed. Saving a new
+ *            snapshot to the same path is fine, as it replaces the file
+ *            instead of writing into it.
+ */
+class SnapshotView {
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The contents of the file, or nullptr if it failed to open.
+     */
+    const char* contents;
+
+    /**
+     * @brief The size of the contents, in bytes.
+     */
+    size_t contentsSize;
+
+    /**
+     * @brief The contents, if they were read instead of mapped.
+     */
+    vector<char> buffer;
+
+    /**
+     * @brief The sorted keys, in the contents.
+     */
+    const int* keyArray;
+
+    /**
+     * @brief The data of the keys, in the contents.
+     */
+    const char* dataArray;
+
+    /**
+     * @brief The number of entries.
+     */
+    size_t count;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief A service method that returns the index of the first key that is
+     *        larger or equal to a given key.
+     * 
+     * @param key The key.
+     * 
+     * @retval size_t The index, or count if all the keys are smaller.
+     */
+    size_t LowerBound(const int key) const noexcept;
+
+    /**
+     * @brief A service method that checks the contents of the file, and points
+     *        keys and data into them.
+     * 
+     * @param shouldVerify True to check the checksum and the order of the keys
+     *                     as well.
+     * 
+     * @retval true  If the contents are valid.
+     * @retval false Otherwise.
+     */
+    bool Attach(const bool shouldVerify) noexcept;
+
+    /**
+     * @brief A service method that unmaps the contents, and leaves the view
+     *        empty.
+     */
+    void Close() noexcept;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The view's constructor. Opens and maps a snapshot file, and checks
+     *        its header.
+     * 
+     * @param path         The path of the file.
+     * @param shouldVerify True to check the checksum and the order of the keys
+     *                     as well. This reads the whole file.
+     */
+    explicit SnapshotView(const string& path, const bool shouldVerify = false);
+
+    /**
+     * @brief The view's destructor. Unmaps the file.
+     */
+    ~SnapshotView() noexcept;
+
+    SnapshotView(const SnapshotView&) = delete;
+    SnapshotView& operator=(const SnapshotView&) = delete;
+
+    /**
+     * @brief Checks whether the file was opened.
+     * 
+     * @retval true  If the file was opened, and it is valid.
+     * @retval false Otherwise (the view is empty).
+     */
+    bool IsOpen() const noexcept;
+
+    /**
+     * @brief Searches a key in the snapshot.
+     * 
+     * @param key  The key to look for.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the key was found.
+     * @retval false If the key does not exist in the snapshot, or data is
+     *               nullptr.
+     */
+    bool Search(const int key, char* data) const noexcept;
+
+    /**
+     * @brief Scans the snapshot from a key upwards, as
+     *        ConcurrentDoublyLinkedList::Scan does.
+     * 
+     * @param key     The lowest key to visit (it does not have to exist in the
+     *                snapshot).
+     * @param visitor A function that gets each key and its data, in an
+     *                increasing order of the keys, and returns whether the
+     *                scan should go on.
+     */
+    void Scan(const int key,
+              const function<bool(const int, const char)>& visitor) const;
+
+    /**
+     * @brief Returns the lowest key in the snapshot, with its data.
+     * 
+     * @param key  An output parameter, to which the key should be written.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the key and data were retrieved.
+     * @retval false If the snapshot is empty or an output parameter is invalid.
+     */
+    bool PeekMin(int* key, char* data) const noexcept;
+
+    /**
+     * @brief Returns the highest key in the snapshot, with its data.
+     * 
+     * @param key  An output parameter, to which the key should be written.
+     * @param data An output parameter, to which the data should be written.
+     * 
+     * @retval true  If the key and data were retrieved.
+     * @retval false If the snapshot is empty or an output parameter is invalid.
+     */
+    bool PeekMax(int* key, char* data) const noexcept;
+
+    /**
+     * @brief Returns the number of entries in the snapshot.
+     * 
+     * @retval size_t The number of entries.
+     */
+    size_t Size() const noexcept;
+
+    /**
+     * @brief Returns the number of entries in the snapshot. Exact, as the
+     *        snapshot does not change (see Size).
+     * 
+     * @retval size_t The number of entries.
+     */
+    size_t ApproximateSize() const noexcept;
+
+    /**
+     * @brief Returns the number of keys in the snapshot that are smaller than
+     *        a given key (which does not have to exist in it).
+     * 
+     * @param key The key.
+     * 
+     * @retval size_t The rank of the key.
+     */
+    size_t Rank(const int key) const noexcept;
+
+    /**
+     * @brief Returns the key at a given position of the increasing order of
+     *        the keys.
+     * 
+     * @param index The position, starting at 0.
+     * @param key   An output parameter, to which the key should be written.
+     * 
+     * @retval true  If the key was retrieved.
+     * @retval false If index is out of range, or key is nullptr.
+     */
+    bool Select(const size_t index, int* key) const noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* SNAPSHOT_VIEW_H_ */
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: StripedCounter.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "StripedCounter.h"
+#include "ThreadSlot.h"
+
+using std::memory_order_relaxed;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * StripedCounter:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+StripedCounter::StripedCounter() noexcept : total(0) {
+    for(Stripe& stripe : stripes) {
+        stripe.delta.store(0, memory_order_relaxed);
+    }
+}
+
+void StripedCounter::Add(const long delta) noexcept {
+    Stripe& stripe(stripes[ThreadSlot::Index() % STRIPES_NUMBER]);
+
+    const long value(stripe.delta.fetch_add(delta, memory_order_relaxed) + \
+                     delta);
+    if(value >= BATCH_SIZE || value <= -BATCH_SIZE) {
+        // Another thread that shares the stripe may have folded it in the
+        // meantime, so we fold whatever we take out of it.
+        total.fetch_add(stripe.delta.exchange(0, memory_order_relaxed),
+                        memory_order_relaxed);
+    }
+}
+
+long StripedCounter::Sum() const noexcept {
+    long sum(total.load(memory_order_relaxed));
+    for(const Stripe& stripe : stripes) {
+        sum += stripe.delta.load(memory_order_relaxed);
+    }
+    return sum;
+}
+
+long StripedCounter::ApproximateSum() const noexcept {
+    const long approximateSum(total.load(memory_order_relaxed));
+    const long maxError(static_cast<long>(STRIPES_NUMBER) * BATCH_SIZE);
+    if(approximateSum < maxError && approximateSum > -maxError) return Sum();
+    return approximateSum;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
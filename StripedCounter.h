@@ -0,0 +1,136 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: StripedCounter.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef STRIPED_COUNTER_H_
+#define STRIPED_COUNTER_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ListOptions.h"
+#include <atomic>
+#include <cstddef>
+
+using std::atomic;
+using std::size_t;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A scalable counter, for counters that are updated much more often
+ *        than they are read.
+ * 
+ * Behavior:
+ *  - The counter is split into stripes, each on its own cache line. A thread
+ *    updates only the stripe chosen by its thread slot, so threads rarely
+ *    write to the same cache line.
+ *  - When the absolute value of a stripe reaches a batch size, the stripe is
+ *    folded into a global total. Thus, reading the total alone is cheap and
+ *    approximate, with an error bounded by STRIPES_NUMBER * BATCH_SIZE. A
+ *    total within this bound may be mostly error, so the stripes are summed
+ *    as well then.
+ *  - Summing the total and all the stripes is exact when there are no
+ *    concurrent updates.
+ */
+class StripedCounter {
+
+/**-----------------------------------------------------------------------------
+ * Private Definitions:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The number of stripes.
+     */
+    static constexpr unsigned int STRIPES_NUMBER = 64;
+
+    /**
+     * @brief A stripe is folded into the total when its absolute value reaches
+     *        this size.
+     */
+    static constexpr long BATCH_SIZE = 64;
+
+    /**
+     * @brief A single stripe, padded to a cache line.
+     */
+    struct alignas(CACHE_LINE_SIZE) Stripe {
+
+        /**
+         * @brief The part of the count that was not folded into the total yet.
+         */
+        atomic<long> delta;
+    };
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief The folded part of the count.
+     */
+    alignas(CACHE_LINE_SIZE) atomic<long> total;
+
+    /**
+     * @brief The stripes.
+     */
+    Stripe stripes[STRIPES_NUMBER];
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The counter's constructor. The count starts at zero.
+     */
+    StripedCounter() noexcept;
+
+    /**
+     * @brief Adds a delta to the count.
+     * 
+     * @param delta The value to add (may be negative).
+     */
+    void Add(const long delta) noexcept;
+
+    /**
+     * @brief Returns the count, by summing the total and all the stripes.
+     *        The result is exact if there are no concurrent updates.
+     * 
+     * @retval long The count.
+     */
+    long Sum() const noexcept;
+
+    /**
+     * @brief Returns the folded total, in O(1). The result may differ from the
+     *        exact count by STRIPES_NUMBER * BATCH_SIZE at most. If the
+     *        absolute value of the total is below this bound, the stripes are
+     *        summed as well (see Sum), so a small count is not lost in them.
+     * 
+     * @retval long The approximate count.
+     */
+    long ApproximateSum() const noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* STRIPED_COUNTER_H_ */
\ No newline at end of file
@@ -21,20 +21,56 @@
  * ===========================================================================*/
 
 #include "ConcurrentDoublyLinkedList.h"
+#include "SnapshotView.h"
+#include "DurableList.h"
+#include "ShardedConcurrentList.h"
+#include "FlatCombiningList.h"
+#include "DelegatedList.h"
+#include "EliminationList.h"
+#include "NumaNode.h"
 #include <string>
 #include <iostream>
 #include <random>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <filesystem>
+#include <future>
+#ifdef LIST_HAS_COROUTINES
+#include <deque>
+#endif
+#ifdef LIST_HAS_HUGE_PAGES
+#include <sys/mman.h>
+#include <cstdint>
+#endif
 
 using std::cout;
 using std::endl;
 using std::string;
 using std::to_string;
+using std::make_unique;
 using std::scoped_lock;
 using std::random_device;
 using std::mt19937;
 using std::uniform_int_distribution;
+using std::remove;
+using std::map;
+using std::set;
+using std::future;
+using std::filesystem::file_size;
+using std::filesystem::resize_file;
+using std::filesystem::copy_file;
+using std::filesystem::copy_options;
+using std::chrono::milliseconds;
+using std::minstd_rand;
+#ifdef LIST_HAS_COROUTINES
+using std::deque;
+#endif
+#ifdef LIST_HAS_HUGE_PAGES
+using std::uintptr_t;
+#endif
 
 /**=============================================================================
  * Definitions:
@@ -45,7 +81,13 @@ typedef ConcurrentDoublyLinkedList List;
 /**
  * @brief Enumeration type for the different operations on the list.
  */
-enum Operation {INSERT_HEAD, INSERT_TAIL, DELETE, SEARCH};
+enum Operation {INSERT_HEAD, INSERT_TAIL, DELETE, SEARCH, UPSERT, UPDATE,
+                FETCH_ADD, POP_MIN, POP_MAX, TRY_INSERT, TRY_SEARCH,
+                INSERT_AND_SCAN, COMPACT,
+#ifdef LIST_HAS_COROUTINES
+                SEARCH_ASYNC,
+#endif
+                OPERATIONS_NUMBER};
 
 /**=============================================================================
  * Declarations:
@@ -124,13 +166,234 @@ void Finish(const string& threadID);
  */
 void ThreadTask(const string&& threadID);
 
+/**
+ * @brief Runs a random operation on the list from each of MAX_THREADS threads,
+ *        released together, and then checks the list's size, its rank index,
+ *        its split and splice, and its snapshots.
+ * 
+ * @param options The configuration of the list.
+ */
+void TestRandomOperations(const ListOptions& options);
+
+/**
+ * @brief Tests the recovery of a durable list: concurrent writes, a
+ *        checkpoint, more writes, a log that a crash cut in the middle of a
+ *        record, and a replay of a log over the newer snapshot of a checkpoint
+ *        that a crash cut before it emptied the log.
+ */
+void TestDurableList();
+
+/**
+ * @brief Returns the result of an operation that was run synchronously.
+ * 
+ * @param result The result of the operation.
+ * 
+ * @retval bool The result of the operation.
+ */
+bool Outcome(const bool result) noexcept;
+
+/**
+ * @brief Waits for the result of an operation that was handed to another
+ *        thread.
+ * 
+ * @param result The future result of the operation.
+ * 
+ * @retval bool The result of the operation.
+ */
+bool Outcome(future<bool>&& result);
+
+/**
+ * @brief Runs random insertions, deletions and searches on a map from several
+ *        threads, and then checks the map's contents. Each thread works on its
+ *        own keys, so the result of every operation is known in advance.
+ * 
+ * @param map       The map to test (empty).
+ * @param meanwhile Called by the calling thread while the workers run, with a
+ *                  flag that is cleared once they are done.
+ */
+template<typename Map>
+void TestDisjointWorkload(Map& map,
+                          const function<void(const atomic<bool>&)>& meanwhile);
+
+/**
+ * @brief Runs random insertions, deletions and searches of a few keys on a map
+ *        from several threads, so operations on the same key run concurrently,
+ *        and then checks the map's contents. Each key must be in the map
+ *        exactly if its successful insertions outnumber its successful
+ *        deletions.
+ * 
+ * @param map The map to test (empty).
+ */
+template<typename Map>
+void TestContendedWorkload(Map& map);
+
+/**
+ * @brief Tests the flat-combining, delegated and elimination front ends under
+ *        random workloads, with disjoint and with contended keys.
+ */
+void TestFrontEnds();
+
+/**
+ * @brief Tests a list whose nodes are allocated from huge-paged arenas of the
+ *        NUMA nodes, across several huge-page regions, and the accounting of
+ *        the regions of an arena: a region is unmapped once all of its chunks
+ *        were returned, including the chunks that the arena never carved.
+ */
+void TestNodeArenas();
+
+/**
+ * @brief Tests the rank index alone, under concurrent additions and removals
+ *        of keys that are spread over the whole int range, so subtrees are
+ *        emptied (and pruned) and refilled all the time, while other threads
+ *        query it.
+ */
+void TestRankIndex();
+
+#ifdef LIST_HAS_HUGE_PAGES
+
+/**
+ * @brief Returns whether a page is mapped.
+ * 
+ * @param page The address of the page (aligned to the page size).
+ * 
+ * @retval true  If the page is mapped.
+ * @retval false If the page is not mapped.
+ */
+bool IsMapped(char* const page) noexcept;
+
+#endif /* LIST_HAS_HUGE_PAGES */
+
+/**
+ * @brief Tests a sharded list under a random workload, while another thread
+ *        splits, merges and rebalances its shards.
+ */
+void TestShardedList();
+
+#ifdef LIST_HAS_COROUTINES
+
+/**
+ * @brief A list whose operations are run in one of three ways, chosen at
+ *        random for each operation: blocking, asynchronous and resumed by the
+ *        thread that runs it (in AsyncTask::Get), or asynchronous and resumed
+ *        by a scheduler thread. Thus, blocking and asynchronous operations wait
+ *        for each other's locks.
+ */
+class MixedList {
+
+    /**
+     * @brief The list.
+     */
+    List list;
+
+    /**
+     * @brief Protects queue and isStopping.
+     */
+    mutex queueMutex;
+
+    /**
+     * @brief The scheduler thread waits on it for coroutines to resume.
+     */
+    condition_variable queueCondition;
+
+    /**
+     * @brief The coroutines that were posted to the scheduler thread.
+     */
+    deque<coroutine_handle<>> queue;
+
+    /**
+     * @brief Whether the scheduler thread should exit.
+     */
+    bool isStopping;
+
+    /**
+     * @brief The scheduler thread, which resumes the posted coroutines.
+     */
+    thread schedulerThread;
+
+    /**
+     * @brief The main loop of the scheduler thread.
+     */
+    void Schedule();
+
+    /**
+     * @brief Chooses how to run an operation.
+     * 
+     * @param scheduler An output parameter for the scheduler of an
+     *                  asynchronous operation (empty for resumption by the
+     *                  thread that runs it).
+     * 
+     * @retval true  If the operation should be run asynchronously.
+     * @retval false If the operation should be run by the blocking API.
+     */
+    bool IsAsync(AsyncScheduler* scheduler);
+
+public:
+
+    /**
+     * @brief The mixed list's constructor. Starts the scheduler thread.
+     */
+    MixedList();
+
+    /**
+     * @brief The mixed list's destructor. Joins the scheduler thread.
+     * 
+     * @attention It is assumed that no operation is in progress.
+     */
+    ~MixedList() noexcept;
+
+    MixedList(const MixedList&) = delete;
+    MixedList& operator=(const MixedList&) = delete;
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::InsertHead and InsertAsync.
+     */
+    bool InsertHead(const int key, const char data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Delete and DeleteAsync.
+     */
+    bool Delete(const int key);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Search and SearchAsync.
+     */
+    bool Search(const int key, char* data);
+
+    /**
+     * @brief See ConcurrentDoublyLinkedList::Size.
+     */
+    size_t Size() const noexcept;
+};
+
+/**
+ * @brief Inserts a key asynchronously, and then goes on with blocking
+ *        operations on it, from wherever the coroutine was resumed.
+ * 
+ * @param list The list.
+ * @param key  The key, which is owned by the calling thread.
+ * 
+ * @retval true  If all the operations returned as expected.
+ * @retval false Otherwise.
+ */
+AsyncTask<bool> InsertThenDelete(List& list, const int key);
+
+/**
+ * @brief Tests the asynchronous operations, mixed with blocking ones on the
+ *        same list, under random workloads with disjoint and with contended
+ *        keys, and coroutines that go on with blocking operations once they
+ *        are resumed.
+ */
+void TestAsyncList();
+
+#endif /* LIST_HAS_COROUTINES */
+
 /*==============================================================================
  * Global Variables:
  *============================================================================*/
 
 const unsigned int       MAX_THREADS(1000);
 unsigned int             threadCounter(0);
-List                     clist;
+unique_ptr<List>         clist;
 condition_variable       childrenCondition,
                          parentCondition;
 mutex                    globalMutex,
@@ -140,8 +403,10 @@ mt19937                  generator(rd());
 uniform_int_distribution randomKey(1, 100),
                          randomData(33, 126),
                          randomOperation(static_cast<int>(INSERT_HEAD),
-                                         static_cast<int>(SEARCH));
+                                         static_cast<int>(OPERATIONS_NUMBER -
+                                                          1));
 bool                     ready(false);
+atomic<long>             expectedSize(0);
 
 /*==============================================================================
  * Implementation:
@@ -156,18 +421,56 @@ string GetOperation(const string& threadID,
                     const string& key,
                     const string& data,
                     const Operation op) {
-    const string operations[4]{"InsertHead", "InsertTail", "Delete", "Search"};
+    const string operations[OPERATIONS_NUMBER]{"InsertHead",
+                                               "InsertTail",
+                                               "Delete",
+                                               "Search",
+                                               "Upsert",
+                                               "Update",
+                                               "FetchAdd",
+                                               "PopMin",
+                                               "PopMax",
+                                               "TryInsert",
+                                               "TrySearch",
+                                               "InsertAndScan",
+                                               "Compact",
+#ifdef LIST_HAS_COROUTINES
+                                               "SearchAsync",
+#endif
+                                               };
     
-    string result(threadID + ": " + operations[op] + "(" + key);
+    string result(threadID + ": " + operations[op] + "(");
     switch(op) {
         case DELETE:
-            result += ")";
+            result += key + ")";
             break;
         case SEARCH:
-            result += ", &data)";
+#ifdef LIST_HAS_COROUTINES
+        case SEARCH_ASYNC:
+#endif
+            result += key + ", &data)";
+            break;
+        case FETCH_ADD:
+            result += key + ", 1, &data)";
+            break;
+        case POP_MIN:
+        case POP_MAX:
+            result += "&key, &data)";
+            break;
+        case TRY_INSERT:
+            result += key + ", " + data + ", 1ms)";
+            break;
+        case TRY_SEARCH:
+            result += key + ", &data, 1ms)";
+            break;
+        case INSERT_AND_SCAN:
+            result += key + ", " + data + ", visitor)";
+            break;
+        case COMPACT:
+            result += ")";
             break;
         default:
-            result += ", " + data + ")";
+            result += key + ", " + data + ")";
     }
     
     return result;
@@ -186,7 +489,15 @@ void PrintOperationResult(const string& threadID,
                           const Operation op,
                           const bool result) {
     string suffix(result ? "true" : "false");
-    if(op == SEARCH && result) {
+    if((op == POP_MIN || op == POP_MAX) && result) {
+        suffix += ", key = " + key;
+    }
+    bool hasData(op == SEARCH || op == FETCH_ADD || op == POP_MIN || \
+                 op == POP_MAX || op == TRY_SEARCH);
+#ifdef LIST_HAS_COROUTINES
+    hasData = hasData || op == SEARCH_ASYNC;
+#endif
+    if(hasData && result) {
         suffix += ", data = " + data;
     }
     SafePrint(GetOperation(threadID, key, data, op) + " - " + suffix);
@@ -214,7 +525,7 @@ void Finish(const string& threadID) {
 }
 
 void ThreadTask(const string&& threadID) {
-    const int key(randomKey(generator));
+    int key(randomKey(generator));
     char data(static_cast<char>(randomData(generator)));
     const Operation op(static_cast<Operation>(randomOperation(generator)));
 
@@ -226,34 +537,558 @@ void ThreadTask(const string&& threadID) {
     PrintOperation(threadID, keyStr, string() + data, op);
     switch(op) {
         case INSERT_HEAD:
-            result = clist.InsertHead(key, data);
+            result = clist->InsertHead(key, data);
             break;
         case INSERT_TAIL:
-            result = clist.InsertTail(key, data);
+            result = clist->InsertTail(key, data);
             break;
         case DELETE:
-            result = clist.Delete(key);
+            result = clist->Delete(key);
             break;
         case SEARCH:
-            result = clist.Search(key, &data);
+            result = clist->Search(key, &data);
+            break;
+        case UPSERT:
+            result = clist->Upsert(key, data);
+            break;
+        case UPDATE:
+            result = clist->Update(key, data);
+            break;
+        case FETCH_ADD:
+            result = clist->FetchAdd(key, 1, &data);
+            break;
+        case POP_MIN:
+            result = clist->PopMin(&key, &data);
+            break;
+        case POP_MAX:
+            result = clist->PopMax(&key, &data, /*sprayWidth = */4);
+            break;
+        case TRY_INSERT:
+            result = clist->TryInsert(key, data, milliseconds(1)) == \
+                     List::SUCCEEDED;
             break;
+        case TRY_SEARCH:
+            result = clist->TrySearch(key, &data, milliseconds(1)) == \
+                     List::SUCCEEDED;
+            break;
+        case INSERT_AND_SCAN: {
+            // The scan starts at the key, and its keys are increasing.
+            int lastKey(key - 1);
+            const auto visitor([&lastKey](const int scanned,
+                                          const char) noexcept {
+                assert(scanned > lastKey);
+                lastKey = scanned;
+                return true;
+            });
+            result = clist->InsertAndScan(key, data, visitor);
+            break;
+        }
+        case COMPACT:
+            result = clist->Compact() > 0;
+            break;
+#ifdef LIST_HAS_COROUTINES
+        case SEARCH_ASYNC:
+            // Runs while other threads compact the list, so it may pass
+            // relocated nodes.
+            result = clist->SearchAsync(key, &data).Get();
+            break;
+#endif
         default:
             // Should not arrive here.
             assert(op != INSERT_HEAD && \
                    op != INSERT_TAIL && \
                    op != DELETE      && \
-                   op != SEARCH);
+                   op != SEARCH      && \
+                   op != UPSERT      && \
+                   op != UPDATE      && \
+                   op != FETCH_ADD   && \
+                   op != POP_MIN     && \
+                   op != POP_MAX     && \
+                   op != TRY_INSERT  && \
+                   op != TRY_SEARCH  && \
+                   op != INSERT_AND_SCAN && \
+                   op != COMPACT);
+    }
+    PrintOperationResult(threadID, to_string(key), string() + data, op, result);
+
+    if(result && (op == INSERT_HEAD || op == INSERT_TAIL || op == UPSERT || \
+                  op == TRY_INSERT || op == INSERT_AND_SCAN)) {
+        ++expectedSize;
+    } else if(result && (op == DELETE || op == POP_MIN || op == POP_MAX)) {
+        --expectedSize;
     }
-    PrintOperationResult(threadID, keyStr, string() + data, op, result);
 
     Finish(threadID);
 }
 
-int main() {
-    SafePrint("Test started.");
-    
+void TestDurableList() {
+    const string snapshotPath("Test.durable.snapshot"),
+                 logPath("Test.durable.log"),
+                 oldLogPath("Test.durable.log.old");
+    const int WRITERS(4), KEYS(200), LAST_KEY(1000);
+    remove(snapshotPath.c_str());
+    remove(logPath.c_str());
+
+    map<int, char> expected;
+    const auto check([&expected](DurableList& list) {
+        assert(list.IsOpen() && list.Size() == expected.size());
+        for(const auto& [key, data] : expected) {
+            char found(0);
+            assert(list.Search(key, &found) && found == data);
+        }
+    });
+
+    {
+        DurableList list(snapshotPath, logPath);
+        assert(list.IsOpen() && list.Size() == 0);
+
+        // The writers wait for the flushes together.
+        vector<thread> writers;
+        for(int writer = 0; writer < WRITERS; ++writer) {
+            writers.emplace_back([&list, writer]() {
+                for(int key = writer; key < KEYS; key += WRITERS) {
+                    const char data(static_cast<char>('a' + key % 26));
+                    assert(list.InsertHead(key, data) == \
+                           DurableList::SUCCEEDED);
+                }
+                assert(list.InsertTail(writer, '0') == DurableList::FAILED);
+            });
+        }
+        for(thread& writer : writers) {
+            writer.join();
+        }
+        for(int key = 0; key < KEYS; key += 2) {
+            assert(list.Delete(key) == DurableList::SUCCEEDED);
+        }
+        assert(list.Delete(0) == DurableList::FAILED);
+        for(int key = 1; key < KEYS; key += 2) {
+            expected[key] = static_cast<char>('a' + key % 26);
+        }
+        check(list);
+
+        assert(list.Checkpoint());
+        assert(list.InsertTail(KEYS, 'x') == DurableList::SUCCEEDED);
+        assert(list.Delete(1) == DurableList::SUCCEEDED);
+        assert(list.InsertHead(1, 'y') == DurableList::SUCCEEDED);
+        expected[KEYS] = 'x';
+        expected[1] = 'y';
+        assert(list.InsertTail(LAST_KEY, 'z') == DurableList::SUCCEEDED);
+    }
+
+    // A crash in the middle of the last record.
+    resize_file(logPath,
+                file_size(logPath) - sizeof(WriteAheadLog::Record) / 2);
+    {
+        DurableList list(snapshotPath, logPath);
+        check(list);
+        assert((file_size(logPath) - sizeof(WriteAheadLog::Header)) % \
+               sizeof(WriteAheadLog::Record) == 0);
+
+        assert(list.InsertTail(LAST_KEY, 'w') == DurableList::SUCCEEDED);
+        assert(list.Delete(KEYS) == DurableList::SUCCEEDED);
+        expected[LAST_KEY] = 'w';
+        expected.erase(KEYS);
+        check(list);
+
+        copy_file(logPath, oldLogPath, copy_options::overwrite_existing);
+        assert(list.Checkpoint());
+    }
+
+    // A crash after the checkpoint's snapshot, before it emptied the log.
+    copy_file(oldLogPath, logPath, copy_options::overwrite_existing);
+    {
+        DurableList list(snapshotPath, logPath);
+        check(list);
+    }
+
+    remove(snapshotPath.c_str());
+    remove(logPath.c_str());
+    remove(oldLogPath.c_str());
+    SafePrint("Durable list test ended successfully.");
+}
+
+bool Outcome(const bool result) noexcept {
+    return result;
+}
+
+bool Outcome(future<bool>&& result) {
+    return result.get();
+}
+
+template<typename Map>
+void TestDisjointWorkload(Map& map,
+                          const function<void(const atomic<bool>&)>&
+                                                                    meanwhile) {
+    const int WORKERS(4), KEYS(1000), OPERATIONS(20000);
+    vector<std::map<int, char>> expected(WORKERS);
+    atomic<int> runningWorkers(WORKERS);
+    atomic<bool> isRunning(true);
+
+    vector<thread> workers;
+    for(int worker = 0; worker < WORKERS; ++worker) {
+        workers.emplace_back([&map, &expected, &runningWorkers, &isRunning,
+                              worker, seed = rd()]() {
+            // The worker's keys are the keys in [-KEYS / 2, KEYS / 2) that are
+            // congruent to it modulo WORKERS.
+            mt19937 workerGenerator(seed);
+            uniform_int_distribution randomIndex(0, KEYS / WORKERS - 1),
+                                     randomChoice(0, 2);
+            std::map<int, char>& owned(expected[static_cast<size_t>(worker)]);
+            for(int i = 0; i < OPERATIONS; ++i) {
+                const int key(randomIndex(workerGenerator) * WORKERS + \
+                              worker - KEYS / 2);
+                const char data(static_cast<char>('a' + i % 26));
+                const bool isOwned(owned.count(key) > 0);
+                char found(0);
+                switch(randomChoice(workerGenerator)) {
+                    case 0:
+                        assert(Outcome(map.InsertHead(key, data)) == \
+                               !isOwned);
+                        owned.emplace(key, data);
+                        break;
+                    case 1:
+                        assert(Outcome(map.Delete(key)) == isOwned);
+                        owned.erase(key);
+                        break;
+                    default:
+                        assert(Outcome(map.Search(key, &found)) == isOwned);
+                        assert(!isOwned || found == owned[key]);
+                }
+            }
+            if(--runningWorkers == 0) isRunning = false;
+        });
+    }
+    meanwhile(isRunning);
+    for(thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t size(0);
+    for(const std::map<int, char>& owned : expected) {
+        size += owned.size();
+    }
+    assert(map.Size() == size);
+    for(int key = -KEYS / 2; key < KEYS / 2; ++key) {
+        const std::map<int, char>& owned(
+                   expected[static_cast<size_t>((key + KEYS / 2) % WORKERS)]);
+        const auto entry(owned.find(key));
+        char found(0);
+        assert(Outcome(map.Search(key, &found)) == (entry != owned.end()));
+        assert(entry == owned.end() || found == entry->second);
+    }
+}
+
+template<typename Map>
+void TestContendedWorkload(Map& map) {
+    const int WORKERS(4), KEYS(8), OPERATIONS(20000);
+    vector<vector<long>> changes(WORKERS, vector<long>(KEYS, 0));
+
+    vector<thread> workers;
+    for(size_t worker = 0; worker < WORKERS; ++worker) {
+        workers.emplace_back([&map, &changes, worker, seed = rd()]() {
+            mt19937 workerGenerator(seed);
+            uniform_int_distribution randomKeyIndex(0, KEYS - 1),
+                                     randomChoice(0, 2);
+            vector<long>& workerChanges(changes[worker]);
+            for(int i = 0; i < OPERATIONS; ++i) {
+                const int key(randomKeyIndex(workerGenerator));
+                const char data(static_cast<char>('a' + key));
+                char found(0);
+                switch(randomChoice(workerGenerator)) {
+                    case 0:
+                        workerChanges[static_cast<size_t>(key)] += \
+                                          Outcome(map.InsertHead(key, data));
+                        break;
+                    case 1:
+                        workerChanges[static_cast<size_t>(key)] -= \
+                                          Outcome(map.Delete(key));
+                        break;
+                    default:
+                        // Every insertion of the key has the same data.
+                        assert(!Outcome(map.Search(key, &found)) || \
+                               found == data);
+                }
+            }
+        });
+    }
+    for(thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t size(0);
+    for(int key = 0; key < KEYS; ++key) {
+        long change(0);
+        for(const vector<long>& workerChanges : changes) {
+            change += workerChanges[static_cast<size_t>(key)];
+        }
+        char found(0);
+        assert((change == 0 || change == 1) && \
+               Outcome(map.Search(key, &found)) == (change == 1));
+        size += static_cast<size_t>(change);
+    }
+    assert(map.Size() == size);
+}
+
+void TestFrontEnds() {
+    const auto nothing([](const atomic<bool>&) noexcept {});
+    {
+        FlatCombiningList disjoint, contended;
+        TestDisjointWorkload(disjoint, nothing);
+        TestContendedWorkload(contended);
+    }
+    {
+        DelegatedList disjoint({-250, 0, 250}), contended({4});
+        TestDisjointWorkload(disjoint, nothing);
+        TestContendedWorkload(contended);
+    }
+    {
+        EliminationList disjoint, contended;
+        TestDisjointWorkload(disjoint, nothing);
+        TestContendedWorkload(contended);
+    }
+    SafePrint("Front ends test ended successfully.");
+}
+
+void TestNodeArenas() {
+    {
+        ListOptions options;
+        options.numaPolicy = ListOptions::NUMA_LOCAL;
+        options.isHugePaged = true;
+        List list(options);
+
+        // Nodes for several regions, inserted at the tail in O(1) each.
+        const int NODES(static_cast<int>(4 * NodeArena::HUGE_PAGE_SIZE / 128));
+        for(int key = 0; key < NODES; ++key) {
+            assert(list.InsertTail(key, static_cast<char>('a' + key % 26)));
+        }
+
+        // The first regions are unmapped as their nodes are freed.
+        for(int key = 0; key < NODES / 2; ++key) {
+            int popped(0);
+            char data(0);
+            assert(list.PopMin(&popped, &data) && popped == key);
+        }
+
+        // The copies are carved out of new regions, and the old regions are
+        // unmapped as the old nodes are freed.
+        assert(list.Compact() == NODES / 2 && list.Size() == NODES / 2);
+        int nextKey(NODES / 2);
+        list.Scan(nextKey, [&nextKey](const int key, const char data) noexcept {
+            assert(key == nextKey && data == static_cast<char>('a' + key % 26));
+            ++nextKey;
+            return true;
+        });
+        assert(nextKey == NODES);
+        assert(list.NumaNodeOf(1) < static_cast<int>(NumaNode::Count()));
+    }
+
+#ifdef LIST_HAS_HUGE_PAGES
+    const size_t SIZE(64), FULL_REGIONS(3);
+    const auto regionOf([](char* const allocation) noexcept {
+        return reinterpret_cast<char*>(
+                              reinterpret_cast<uintptr_t>(allocation) & \
+                              ~(NodeArena::HUGE_PAGE_SIZE - 1));
+    });
+
+    // The allocations of each region, until the region after the full ones
+    // was started.
+    unique_ptr<NodeArena> arena(make_unique<NodeArena>(NumaNode::Current(),
+                                                       /*isHugePaged = */true));
+    vector<vector<char*>> regions;
+    while(regions.size() <= FULL_REGIONS) {
+        char* const allocation(static_cast<char*>(arena->Allocate(SIZE,
+                                                                  SIZE)));
+        *allocation = 'a';
+        if(regions.empty() || \
+           regionOf(regions.back().front()) != regionOf(allocation)) {
+            regions.emplace_back();
+        }
+        regions.back().push_back(allocation);
+    }
+    for(size_t i = 1; i < FULL_REGIONS; ++i) {
+        assert(regions[i].size() == regions[0].size());
+    }
+
+    // A region stays mapped while any of its chunks is in use.
+    for(size_t i = 0; i < FULL_REGIONS; ++i) {
+        char* const region(regionOf(regions[i].front()));
+        for(char* const allocation : regions[i]) {
+            assert(IsMapped(region));
+            NodeArena::Deallocate(allocation);
+        }
+        assert(!IsMapped(region));
+    }
+
+    // The arena returns the chunks it did not carve, and the region is
+    // unmapped once the carved ones are freed.
+    char* const lastRegion(regionOf(regions.back().front()));
+    arena.reset();
+    for(char* const allocation : regions.back()) {
+        assert(IsMapped(lastRegion) && *allocation == 'a');
+        NodeArena::Deallocate(allocation);
+    }
+    assert(!IsMapped(lastRegion));
+#endif
+
+    SafePrint("Node arenas test ended successfully.");
+}
+
+#ifdef LIST_HAS_HUGE_PAGES
+
+bool IsMapped(char* const page) noexcept {
+    // Fails with ENOMEM if the page is not mapped.
+    unsigned char residency(0);
+    return mincore(page, 1, &residency) == 0;
+}
+
+#endif /* LIST_HAS_HUGE_PAGES */
+
+void TestShardedList() {
+    ShardedConcurrentList sharded({-250, 0, 250});
+    size_t changes(0);
+    TestDisjointWorkload(sharded, [&sharded, &changes](
+                                              const atomic<bool>& isRunning) {
+        // Operations that were routed by an old table must be retried.
+        for(size_t i = 0; isRunning; ++i) {
+            changes += sharded.Rebalance(/*maxShardSize = */16,
+                                         /*minShardSize = */8);
+            changes += sharded.SplitShard(i % sharded.ShardsNumber());
+            changes += sharded.MergeShards(i % sharded.ShardsNumber());
+        }
+    });
+    SafePrint("Sharded list test ended successfully (" + to_string(changes) + \
+              " splits and merges).");
+}
+
+#ifdef LIST_HAS_COROUTINES
+
+void MixedList::Schedule() {
+    unique_lock<mutex> lock(queueMutex);
+    while(true) {
+        queueCondition.wait(lock, [this]() {
+            return !queue.empty() || isStopping;
+        });
+        if(queue.empty()) return;
+
+        const coroutine_handle<> handle(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        handle.resume();
+        lock.lock();
+    }
+}
+
+bool MixedList::IsAsync(AsyncScheduler* scheduler) {
+    static thread_local minstd_rand modeGenerator(random_device{}());
+    switch(modeGenerator() % 3) {
+        case 0:
+            return false;
+        case 1:
+            *scheduler = nullptr;
+            return true;
+        default:
+            *scheduler = [this](const coroutine_handle<> handle) {
+                scoped_lock<mutex> lock(queueMutex);
+                queue.push_back(handle);
+                queueCondition.notify_one();
+            };
+            return true;
+    }
+}
+
+MixedList::MixedList() : isStopping(false),
+                         schedulerThread(&MixedList::Schedule, this) {
+}
+
+MixedList::~MixedList() noexcept {
+    {
+        scoped_lock<mutex> lock(queueMutex);
+        isStopping = true;
+        queueCondition.notify_one();
+    }
+    schedulerThread.join();
+}
+
+bool MixedList::InsertHead(const int key, const char data) {
+    AsyncScheduler scheduler;
+    return IsAsync(&scheduler) ?
+               list.InsertAsync(key, data, std::move(scheduler)).Get() :
+               list.InsertHead(key, data);
+}
+
+bool MixedList::Delete(const int key) {
+    AsyncScheduler scheduler;
+    return IsAsync(&scheduler) ?
+               list.DeleteAsync(key, std::move(scheduler)).Get() :
+               list.Delete(key);
+}
+
+bool MixedList::Search(const int key, char* data) {
+    AsyncScheduler scheduler;
+    return IsAsync(&scheduler) ?
+               list.SearchAsync(key, data, std::move(scheduler)).Get() :
+               list.Search(key, data);
+}
+
+size_t MixedList::Size() const noexcept {
+    return list.Size();
+}
+
+// GCC warns about the switch statements it generates for coroutines.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-default"
+
+AsyncTask<bool> InsertThenDelete(List& list, const int key) {
+    if(!co_await list.InsertAsync(key, 'a')) co_return false;
+
+    char data;
+    const bool isFound(list.Search(key, &data) && data == 'a');
+    const bool isDeleted(list.Delete(key));
+    co_return isFound && isDeleted && !co_await list.DeleteAsync(key);
+}
+
+#pragma GCC diagnostic pop
+
+void TestAsyncList() {
+    {
+        MixedList disjoint, contended;
+        TestDisjointWorkload(disjoint, [](const atomic<bool>&) noexcept {});
+        TestContendedWorkload(contended);
+    }
+
+    // The workers' keys are interleaved, so their operations wait for each
+    // other's locks, and the continuations must not run while the releasing
+    // thread still holds them.
+    List list;
+    const int WORKERS = 4, KEYS = 4, ITERATIONS = 5000;
+    vector<thread> workers;
+    for(int worker = 0; worker < WORKERS; ++worker) {
+        workers.emplace_back([&list, worker]() {
+            for(int i = 0; i < ITERATIONS; ++i) {
+                const int key((i % KEYS) * WORKERS + worker);
+                assert(InsertThenDelete(list, key).Get());
+            }
+        });
+    }
+    for(thread& worker : workers) worker.join();
+    assert(list.Size() == 0);
+    SafePrint("Asynchronous list test ended successfully.");
+}
+
+#endif /* LIST_HAS_COROUTINES */
+
+void TestRandomOperations(const ListOptions& options) {
+    SafePrint("Random operations with maxSpinRounds = " + \
+              to_string(options.maxSpinRounds) + ", isReadBiased = " + \
+              (options.isReadBiased ? "true" : "false") + \
+              ", traversalPolicy = " + \
+              (options.traversalPolicy == ListOptions::PREFETCHING ?
+                   "PREFETCHING" : "PLAIN") + ".");
+    clist = make_unique<List>(options);
+    expectedSize = 0;
+
     unique_lock<mutex> lock(globalMutex);
-    
+
     assert(!ready);
     for(unsigned int i = 0; i < MAX_THREADS; ++i) {
         thread(ThreadTask, to_string(i + 1)).detach();
@@ -266,6 +1101,144 @@ int main() {
     ready = true;
     childrenCondition.notify_all();
     parentCondition.wait(lock, []{return threadCounter == 0;});
+    ready = false;
+
+    SafePrint("List size: " + to_string(clist->Size()) + " (approximately " + \
+              to_string(clist->ApproximateSize()) + ").");
+    assert(clist->Size() == static_cast<size_t>(expectedSize.load()));
+    assert(clist->ApproximateSize() == clist->Size()); // A small list.
+
+    int key(0);
+    for(size_t i = 0; i < clist->Size(); ++i) {
+        assert(clist->Select(i, &key) && clist->Rank(key) == i);
+    }
+    assert(!clist->Select(clist->Size(), &key));
+
+    const size_t size(clist->Size());
+    if(size > 1) {
+        assert(clist->Select(size / 2, &key));
+        const unique_ptr<List> upper(clist->SplitAt(key));
+        assert(clist->Size() == size / 2 && upper->Size() == size - size / 2);
+        assert(!upper->Splice(*clist) && clist->Splice(*upper));
+        assert(clist->Size() == size && upper->Size() == 0);
+    }
+
+    const string snapshotPath("Test.snapshot");
+    List loaded(ListOptions{/*isRankIndexed = */true});
+    assert(clist->SaveSnapshot(snapshotPath));
+    assert(loaded.LoadSnapshot(snapshotPath) && loaded.Size() == size);
+    assert(!loaded.LoadSnapshot(snapshotPath)); // It is not empty anymore.
+    for(size_t i = 0; i < size; ++i) {
+        char data(0), loadedData(0);
+        assert(clist->Select(i, &key) && clist->Search(key, &data));
+        assert(loaded.Search(key, &loadedData) && loadedData == data);
+    }
+
+    const SnapshotView view(snapshotPath, /*shouldVerify = */true);
+    assert(view.IsOpen() && view.Size() == size);
+    for(size_t i = 0; i < size; ++i) {
+        char data(0), viewData(0);
+        assert(clist->Select(i, &key) && clist->Search(key, &data));
+        assert(view.Search(key, &viewData) && viewData == data);
+        assert(view.Rank(key) == i && !view.Search(key + 1, &viewData) == \
+                                      !clist->Search(key + 1, &data));
+    }
+    int lastKey(numeric_limits<int>::min());
+    size_t scanned(0);
+    clist->Scan(lastKey, [&view, &lastKey, &scanned](const int scannedKey,
+                                                    const char) noexcept {
+        int viewKey(0);
+        assert(view.Select(scanned, &viewKey) && viewKey == scannedKey && \
+               scannedKey > lastKey);
+        lastKey = scannedKey;
+        return ++scanned < 10;
+    });
+    assert(scanned == (size < 10 ? size : 10));
+    remove(snapshotPath.c_str());
+}
+
+void TestRankIndex() {
+    const unsigned int WORKERS = 4, KEYS = 64, ITERATIONS = 20000;
+    const auto Key = [](const unsigned int i) {
+        return static_cast<int>(i * 0x9E3779B1U);
+    };
+
+    KeyRankIndex index;
+    vector<vector<bool>> isAdded(WORKERS, vector<bool>(KEYS, false));
+    atomic<bool> isDone(false);
+    thread querier([&index, &isDone]() noexcept {
+        for(size_t i = 0; !isDone.load(); ++i) {
+            int key(0);
+            if(index.Select(i % KEYS, &key)) index.Rank(key);
+        }
+    });
+    vector<thread> workers;
+    for(unsigned int worker = 0; worker < WORKERS; ++worker) {
+        workers.emplace_back([&index, &isAdded, &Key, worker]() {
+            minstd_rand keyGenerator(worker + 1);
+            vector<bool>& isWorkerAdded(isAdded[worker]);
+            for(unsigned int i = 0; i < ITERATIONS; ++i) {
+                const unsigned int j(keyGenerator() % KEYS);
+                const int key(Key(j * WORKERS + worker));
+                if(isWorkerAdded[j]) {
+                    index.Remove(key);
+                } else {
+                    index.Add(key);
+                }
+                isWorkerAdded[j] = !isWorkerAdded[j];
+            }
+        });
+    }
+    for(thread& worker : workers) worker.join();
+    isDone = true;
+    querier.join();
+
+    set<int> keys;
+    for(unsigned int worker = 0; worker < WORKERS; ++worker) {
+        for(unsigned int j = 0; j < KEYS; ++j) {
+            if(isAdded[worker][j]) keys.insert(Key(j * WORKERS + worker));
+        }
+    }
+    size_t rank(0);
+    int key(0);
+    for(const int added : keys) {
+        assert(index.Select(rank, &key) && key == added && \
+               index.Rank(key) == rank);
+        ++rank;
+    }
+    assert(!index.Select(keys.size(), &key));
+    for(const int added : keys) index.Remove(added);
+    assert(!index.Select(0, &key) && \
+           index.Rank(numeric_limits<int>::max()) == 0);
+    SafePrint("Rank index test ended successfully.");
+}
+
+int main() {
+    SafePrint("Test started.");
+
+    // Every combination of the lock and traversal options.
+    for(const unsigned int maxSpinRounds : {0U, 64U}) {
+        for(const bool isReadBiased : {false, true}) {
+            for(const ListOptions::TraversalPolicy traversalPolicy :
+                            {ListOptions::PLAIN, ListOptions::PREFETCHING}) {
+                ListOptions options;
+                options.isRankIndexed = true;
+                options.maxSpinRounds = maxSpinRounds;
+                options.isReadBiased = isReadBiased;
+                options.traversalPolicy = traversalPolicy;
+                TestRandomOperations(options);
+            }
+        }
+    }
+
+    TestDurableList();
+    TestShardedList();
+    TestFrontEnds();
+    TestNodeArenas();
+    TestRankIndex();
+#ifdef LIST_HAS_COROUTINES
+    TestAsyncList();
+#endif
 
     SafePrint("Test ended successfully.");
 
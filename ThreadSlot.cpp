@@ -0,0 +1,175 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: ThreadSlot.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "ThreadSlot.h"
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+
+using std::mutex;
+using std::scoped_lock;
+using std::vector;
+using std::length_error;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+namespace {
+
+/**
+ * @brief The shared state of the registry, protected by a mutex. It is touched
+ *        only when a thread registers or exits.
+ */
+class Registry {
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Protects the internal variables.
+     */
+    mutex registryMutex;
+
+    /**
+     * @brief Indices of threads that already exited, ready to be reused.
+     */
+    vector<unsigned int> freeIndices;
+
+    /**
+     * @brief The lowest index that was never given to a thread.
+     */
+    unsigned int nextIndex;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The registry's constructor. Room for every index is reserved, so
+     *        returning an index never allocates.
+     */
+    Registry() : nextIndex(0) {
+        freeIndices.reserve(ThreadSlot::MAX_SLOTS);
+    }
+
+    /**
+     * @brief Gives an index to a new thread, preferring reused ones, so indices
+     *        stay as small as possible.
+     * 
+     * @retval unsigned int The index of the new thread.
+     */
+    unsigned int Acquire() {
+        scoped_lock<mutex> lock(registryMutex);
+
+        if(freeIndices.empty()) {
+            if(nextIndex == ThreadSlot::MAX_SLOTS) {
+                throw length_error("ThreadSlot: too many living threads");
+            }
+            return nextIndex++;
+        }
+
+        const unsigned int index(freeIndices.back());
+        freeIndices.pop_back();
+        return index;
+    }
+
+    /**
+     * @brief Returns the index of an exiting thread to the registry.
+     * 
+     * @param index The index of the exiting thread.
+     */
+    void Release(const unsigned int index) noexcept {
+        scoped_lock<mutex> lock(registryMutex);
+
+        freeIndices.push_back(index);
+    }
+};
+
+/**
+ * @brief Returns the single registry. A function-local static is used so the
+ *        registry is constructed before any thread-local slot uses it.
+ */
+Registry& GetRegistry() noexcept {
+    static Registry registry;
+    return registry;
+}
+
+/**
+ * @brief The thread-local holder of a thread's index. Its destructor returns
+ *        the index to the registry when the thread exits.
+ */
+class Slot {
+
+/**-----------------------------------------------------------------------------
+ * Public Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The index of the thread.
+     */
+    const unsigned int index;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief Registers the thread.
+     */
+    Slot() : index(GetRegistry().Acquire()) {
+    }
+
+    /**
+     * @brief Unregisters the thread.
+     */
+    ~Slot() noexcept {
+        GetRegistry().Release(index);
+    }
+};
+
+} // namespace
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * ThreadSlot:
+ ******************************************************************************/
+
+/* public:
+ *********/
+
+unsigned int ThreadSlot::Index() {
+    static thread_local const Slot slot;
+    return slot.index;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: ThreadSlot.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef THREAD_SLOT_H_
+#define THREAD_SLOT_H_
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief A registry of compact thread identifiers.
+ * 
+ * Behavior:
+ *  - Each thread that asks for its slot is registered, and gets a small
+ *    integer index, which is unique among all the currently living threads.
+ *  - The index is kept in a thread-local variable, so asking for it again is
+ *    cheap.
+ *  - When the thread exits, its index is returned to the registry, and may be
+ *    given to another thread.
+ * 
+ * @attention At most MAX_SLOTS threads may be registered at the same time. A
+ *            thread beyond them gets a length_error, instead of an index that
+ *            collides with another thread's. When its first call is made by
+ *            a noexcept method (such as the node locks'), the program is
+ *            terminated.
+ */
+class ThreadSlot {
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The maximal number of threads that can be registered at the same
+     *        time. Indices are in the range [0, MAX_SLOTS).
+     */
+    static constexpr unsigned int MAX_SLOTS = 1U << 15;
+
+    /**
+     * @brief Returns the slot index of the calling thread, registering it on
+     *        the first call.
+     * 
+     * @attention Throws length_error if MAX_SLOTS threads are registered
+     *            already.
+     * 
+     * @retval unsigned int The slot index of the calling thread.
+     */
+    static unsigned int Index();
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* THREAD_SLOT_H_ */
\ No newline at end of file
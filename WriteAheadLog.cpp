@@ -0,0 +1,240 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: WriteAheadLog.cpp
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "WriteAheadLog.h"
+#include <algorithm>
+#include <cstddef>
+#ifdef LIST_HAS_FILE_SYNC
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using std::max;
+using std::scoped_lock;
+using std::unique_lock;
+
+/*==============================================================================
+ * Implementation:
+ *============================================================================*/
+
+/*******************************************************************************
+ * WriteAheadLog:
+ ******************************************************************************/
+
+/* private:
+ **********/
+
+uint32_t WriteAheadLog::Checksum(const Record& record) noexcept {
+    const uint64_t checksum(Snapshot::Checksum(&record,
+                                               offsetof(Record, checksum)));
+    return static_cast<uint32_t>(checksum ^ (checksum >> 32));
+}
+
+bool WriteAheadLog::Replay(const function<void(const Record&)>& replay) {
+#ifdef LIST_HAS_FILE_SYNC
+    Header header{};
+    const ssize_t headerSize(pread(file, &header, sizeof(header), 0));
+    if(headerSize >= 0 && headerSize < static_cast<ssize_t>(sizeof(header))) {
+        // A new log, or one whose creation was cut by a crash.
+        header = Header{MAGIC, VERSION, 0};
+        return ftruncate(file, 0) == 0 && \
+               WriteAndSync(&header, sizeof(header));
+    }
+    if(headerSize != static_cast<ssize_t>(sizeof(header)) || \
+       header.magic != MAGIC || header.version != VERSION || \
+       header.reserved != 0) {
+        return false;
+    }
+
+    // The records are read in blocks, up to the first invalid one.
+    vector<Record> block(4096);
+    off_t end(static_cast<off_t>(sizeof(header)));
+    while(true) {
+        const ssize_t bytes(pread(file,
+                                  block.data(),
+                                  block.size() * sizeof(Record),
+                                  end));
+        if(bytes < 0) return false;
+
+        const size_t records(static_cast<size_t>(bytes) / sizeof(Record));
+        size_t valid(0);
+        while(valid < records && block[valid].operation <= DELETE && \
+              block[valid].reserved == 0 && \
+              block[valid].checksum == Checksum(block[valid])) {
+            replay(block[valid]);
+            ++valid;
+        }
+        end += static_cast<off_t>(valid * sizeof(Record));
+
+        if(valid < block.size()) break;
+    }
+
+    // Appends go to the end of the file, so a torn tail is cut off first.
+    if(lseek(file, 0, SEEK_END) != end) {
+        return ftruncate(file, end) == 0 && WriteAndSync(nullptr, 0);
+    }
+    return true;
+#else
+    static_cast<void>(replay);
+    return false;
+#endif
+}
+
+bool WriteAheadLog::WriteAndSync(const void* const bytes,
+                                 const size_t size) noexcept {
+#ifdef LIST_HAS_FILE_SYNC
+    const char* position(static_cast<const char*>(bytes));
+    size_t left(size);
+    while(left > 0) {
+        const ssize_t written(write(file, position, left));
+        if(written < 0 && errno == EINTR) continue;
+        if(written <= 0) return false;
+
+        position += written;
+        left -= static_cast<size_t>(written);
+    }
+
+#ifdef __linux__
+    return fdatasync(file) == 0;
+#else
+    return fsync(file) == 0;
+#endif
+#else
+    static_cast<void>(bytes);
+    static_cast<void>(size);
+    return false;
+#endif
+}
+
+/* public:
+ *********/
+
+WriteAheadLog::WriteAheadLog(const string& path,
+                             const function<void(const Record&)>& replay) :
+                                                        file(-1),
+                                                        isFlushing(false),
+                                                        hasFailed(false),
+                                                        appendedSequence(0),
+                                                        durableSequence(0),
+                                                        syncsNumber(0) {
+#ifdef LIST_HAS_FILE_SYNC
+    file = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if(file < 0) return;
+
+    // The name of a new log must be durable as well.
+    if(!Replay(replay) || !Snapshot::SyncDirectory(path)) {
+        close(file);
+        file = -1;
+    }
+#else
+    static_cast<void>(path);
+    static_cast<void>(replay);
+#endif
+}
+
+WriteAheadLog::~WriteAheadLog() noexcept {
+    if(file < 0) return;
+
+    if(!pending.empty() && !hasFailed) {
+        WriteAndSync(pending.data(), pending.size() * sizeof(Record));
+    }
+#ifdef LIST_HAS_FILE_SYNC
+    close(file);
+#endif
+}
+
+bool WriteAheadLog::IsOpen() noexcept {
+    scoped_lock<mutex> lock(logMutex);
+    return file >= 0 && !hasFailed;
+}
+
+uint64_t WriteAheadLog::Append(const Operation operation,
+                               const int key,
+                               const char data) {
+    Record record{key, operation, data, 0, 0};
+    record.checksum = Checksum(record);
+
+    scoped_lock<mutex> lock(logMutex);
+    pending.push_back(record);
+    return ++appendedSequence;
+}
+
+bool WriteAheadLog::WaitDurable(const uint64_t sequence) {
+    unique_lock<mutex> lock(logMutex);
+    while(durableSequence < sequence && !hasFailed && file >= 0) {
+        if(isFlushing) {
+            flushEnded.wait(lock);
+            continue;
+        }
+
+        // This thread flushes all the waiting records, including the ones of
+        // the threads that wait for it.
+        isFlushing = true;
+        flushing.swap(pending);
+        const uint64_t flushedSequence(appendedSequence);
+        lock.unlock();
+
+        const bool isWritten(WriteAndSync(flushing.data(),
+                                          flushing.size() * sizeof(Record)));
+        flushing.clear();
+
+        lock.lock();
+        isFlushing = false;
+        ++syncsNumber;
+        if(isWritten) {
+            durableSequence = max(durableSequence, flushedSequence);
+        } else {
+            hasFailed = true;
+        }
+        flushEnded.notify_all();
+    }
+
+    return durableSequence >= sequence;
+}
+
+bool WriteAheadLog::Truncate() {
+    unique_lock<mutex> lock(logMutex);
+    flushEnded.wait(lock, [this]() noexcept {return !isFlushing;});
+
+    pending.clear();
+    durableSequence = appendedSequence;
+#ifdef LIST_HAS_FILE_SYNC
+    if(file >= 0 && !hasFailed && \
+       (ftruncate(file, static_cast<off_t>(sizeof(Header))) != 0 || \
+        !WriteAndSync(nullptr, 0))) {
+        hasFailed = true;
+    }
+#endif
+    flushEnded.notify_all();
+
+    return file >= 0 && !hasFailed;
+}
+
+size_t WriteAheadLog::SyncsNumber() noexcept {
+    scoped_lock<mutex> lock(logMutex);
+    return syncsNumber;
+}
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
\ No newline at end of file
@@ -0,0 +1,309 @@
+/*==============================================================================
+ *******************************************************************************
+ *==============================================================================
+ * File name: WriteAheadLog.h
+ * Author:    Oz Davidi
+ *
+ *                     ****     *********  ***   ***
+ *                    ******    ********   ***   ***
+ *                   ***  ***       ***    ***   ***
+ *                   ***  ***      ***     ***   ***
+ *                   ***  ***     ***      ***   ***
+ *                    ******     ***        *******
+ *                     ****     ***          *****
+ *
+ *==============================================================================
+ *******************************************************************************
+ *============================================================================*/
+
+#ifndef WRITE_AHEAD_LOG_H_
+#define WRITE_AHEAD_LOG_H_
+
+/**=============================================================================
+ * Includes:
+ * ===========================================================================*/
+
+#include "Snapshot.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+using std::condition_variable;
+using std::function;
+using std::mutex;
+
+/**=============================================================================
+ * Declarations:
+ * ===========================================================================*/
+
+/**
+ * @brief An append-only log of list operations, which are flushed to the disk
+ *        with group commit (see DurableList).
+ * 
+ * Behavior:
+ *  - A file is a Header, followed by fixed-size records. Each record has its
+ *    own checksum, so a record that was torn by a crash ends the log.
+ *  - Appended records wait in memory. A thread that waits for its record to
+ *    be durable either becomes the flusher, and writes all the waiting
+ *    records with a single write and fdatasync, or waits for the flush in
+ *    progress. The records that are appended meanwhile go together in the
+ *    next flush, so under load, a single flush serves many threads.
+ *  - Numbers are in the byte order of the machine, as in Snapshot.
+ */
+class WriteAheadLog {
+
+/**-----------------------------------------------------------------------------
+ * Public Definitions:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief Enumeration type for the logged operations.
+     */
+    enum Operation : unsigned char {INSERT_HEAD, INSERT_TAIL, DELETE};
+
+    /**
+     * @brief The header at the beginning of a log file.
+     */
+    struct Header {
+
+        /**
+         * @brief Identifies the file format (MAGIC).
+         */
+        uint64_t magic;
+
+        /**
+         * @brief The version of the file format (VERSION).
+         */
+        uint32_t version;
+
+        /**
+         * @brief Must be 0.
+         */
+        uint32_t reserved;
+    };
+
+    /**
+     * @brief A logged operation.
+     */
+    struct Record {
+
+        /**
+         * @brief The key of the operation.
+         */
+        int key;
+
+        /**
+         * @brief The operation.
+         */
+        Operation operation;
+
+        /**
+         * @brief The data of an insertion, or 0.
+         */
+        char data;
+
+        /**
+         * @brief Must be 0.
+         */
+        unsigned short reserved;
+
+        /**
+         * @brief The checksum of the preceding fields.
+         */
+        uint32_t checksum;
+    };
+
+    static_assert(sizeof(Record) == 12, "Records are saved as they are");
+
+    /**
+     * @brief The magic number of log files ("CDLLWLOG").
+     */
+    static constexpr uint64_t MAGIC = 0x474f4c574c4c4443ULL;
+
+    /**
+     * @brief The current version of the file format.
+     */
+    static constexpr uint32_t VERSION = 1;
+
+/**-----------------------------------------------------------------------------
+ * Private Internal Variables:
+ * ---------------------------------------------------------------------------*/
+
+private:
+
+    /**
+     * @brief The file descriptor of the log, or -1 if it failed to open.
+     */
+    int file;
+
+    /**
+     * @brief Protects the fields below.
+     */
+    mutex logMutex;
+
+    /**
+     * @brief Notified when a flush ends.
+     */
+    condition_variable flushEnded;
+
+    /**
+     * @brief The records that were appended, and were not taken by a flush.
+     */
+    vector<Record> pending;
+
+    /**
+     * @brief The records of the flush in progress. Touched by the flusher
+     *        only, and kept to reuse its memory.
+     */
+    vector<Record> flushing;
+
+    /**
+     * @brief Whether a flush is in progress.
+     */
+    bool isFlushing;
+
+    /**
+     * @brief Whether a flush failed. The log takes no records afterwards.
+     */
+    bool hasFailed;
+
+    /**
+     * @brief The sequence number of the last appended record (the first one
+     *        is 1).
+     */
+    uint64_t appendedSequence;
+
+    /**
+     * @brief The sequence number of the last durable record.
+     */
+    uint64_t durableSequence;
+
+    /**
+     * @brief The number of flushes that were done.
+     */
+    size_t syncsNumber;
+
+/**-----------------------------------------------------------------------------
+ * Private Service Methods:
+ * ---------------------------------------------------------------------------*/
+
+    /**
+     * @brief A service method that computes the checksum of a record.
+     * 
+     * @param record The record.
+     * 
+     * @retval uint32_t The checksum.
+     */
+    static uint32_t Checksum(const Record& record) noexcept;
+
+    /**
+     * @brief A service method that reads the records of the file, applies the
+     *        valid ones, and cuts the file after the last of them.
+     * 
+     * @param replay A function that applies a record.
+     * 
+     * @retval true  If the file was read, and its header is valid.
+     * @retval false Otherwise.
+     */
+    bool Replay(const function<void(const Record&)>& replay);
+
+    /**
+     * @brief A service method that writes bytes to the end of the file, and
+     *        flushes them to the disk.
+     * 
+     * @param bytes The bytes.
+     * @param size  The number of bytes.
+     * 
+     * @retval true  If they were written and flushed.
+     * @retval false Otherwise.
+     */
+    bool WriteAndSync(const void* const bytes, const size_t size) noexcept;
+
+/**-----------------------------------------------------------------------------
+ * Public Methods:
+ * ---------------------------------------------------------------------------*/
+
+public:
+
+    /**
+     * @brief The log's constructor. Opens the log file (or creates it), and
+     *        replays its records. A torn record, and whatever follows it, is
+     *        cut off, so the new records follow the valid ones.
+     * 
+     * @param path   The path of the file.
+     * @param replay A function that applies a replayed record.
+     */
+    WriteAheadLog(const string& path,
+                  const function<void(const Record&)>& replay);
+
+    /**
+     * @brief The log's destructor. Flushes the waiting records, and closes the
+     *        file.
+     */
+    ~WriteAheadLog() noexcept;
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief Checks whether the log can take records.
+     * 
+     * @retval true  If the file was opened and replayed, and no flush failed.
+     * @retval false Otherwise.
+     */
+    bool IsOpen() noexcept;
+
+    /**
+     * @brief Appends a record, in memory. It becomes durable with a later
+     *        flush (see WaitDurable).
+     * 
+     * @param operation The operation.
+     * @param key       The key of the operation.
+     * @param data      The data of an insertion.
+     * 
+     * @retval uint64_t The sequence number of the record.
+     */
+    uint64_t Append(const Operation operation,
+                    const int key,
+                    const char data);
+
+    /**
+     * @brief Waits until a record is durable. The calling thread flushes all
+     *        the waiting records if no flush is in progress, or waits for the
+     *        flush in progress (and then checks again) otherwise.
+     * 
+     * @param sequence The sequence number of the record.
+     * 
+     * @retval true  If the record is durable.
+     * @retval false If a flush failed before the record was written.
+     */
+    bool WaitDurable(const uint64_t sequence);
+
+    /**
+     * @brief Drops all the records, once they are durable elsewhere (in a
+     *        snapshot). The records that wait for a flush are dropped too, and
+     *        count as durable.
+     * 
+     * @attention It is assumed that no records are appended concurrently.
+     * 
+     * @retval true  If the file was cut and flushed.
+     * @retval false Otherwise (the log takes no records afterwards).
+     */
+    bool Truncate();
+
+    /**
+     * @brief Returns the number of flushes that were done (each with a single
+     *        write and fdatasync), for measuring the effect of group commit.
+     * 
+     * @retval size_t The number of flushes.
+     */
+    size_t SyncsNumber() noexcept;
+};
+
+/**=============================================================================
+ * End of file
+ * ===========================================================================*/
+
+#endif /* WRITE_AHEAD_LOG_H_ */
\ No newline at end of file